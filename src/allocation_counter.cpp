@@ -0,0 +1,113 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.hpp"
+
+namespace {
+    thread_local std::uint64_t allocation_count = 0;
+
+    void *allocate(std::size_t size) {
+        allocation_count++;
+        if(size == 0) {
+            size = 1;
+        }
+        while(true) {
+            if(void *pointer = std::malloc(size)) {
+                return pointer;
+            }
+            auto handler = std::get_new_handler();
+            if(!handler) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    // Over-aligned blocks keep the pointer malloc returned just before the block
+    void *allocate_aligned(std::size_t size, std::align_val_t alignment) {
+        auto align = static_cast<std::size_t>(alignment);
+        auto *base = static_cast<std::byte *>(allocate(size + align + sizeof(void *)));
+        auto address = reinterpret_cast<std::uintptr_t>(base + sizeof(void *));
+        auto *aligned = reinterpret_cast<std::byte *>((address + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1));
+        reinterpret_cast<void **>(aligned)[-1] = base;
+        return aligned;
+    }
+
+    void free_aligned(void *pointer) {
+        if(pointer) {
+            std::free(reinterpret_cast<void **>(pointer)[-1]);
+        }
+    }
+}
+
+std::uint64_t get_thread_allocation_count() {
+    return allocation_count;
+}
+
+void *operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size);
+    }
+    catch(std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size);
+    }
+    catch(std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate_aligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate_aligned(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+    free_aligned(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept {
+    free_aligned(pointer);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept {
+    free_aligned(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept {
+    free_aligned(pointer);
+}
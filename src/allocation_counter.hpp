@@ -0,0 +1,13 @@
+#ifndef CARNAGE_REPORTER__ALLOCATION_COUNTER_HPP
+#define CARNAGE_REPORTER__ALLOCATION_COUNTER_HPP
+
+#include <cstdint>
+
+/**
+ * Get how many times the calling thread has allocated with operator new. The global allocation functions are replaced
+ * to count this, so it is only available to programs that link allocation_counter.cpp.
+ * @return number of allocations
+ */
+std::uint64_t get_thread_allocation_count();
+
+#endif
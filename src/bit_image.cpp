@@ -0,0 +1,99 @@
+#include <algorithm>
+
+#include "bit_image.hpp"
+#include "match_kernel.hpp"
+
+BitImage BitImage::create(std::uint32_t width, std::uint32_t height, std::uint32_t padding_columns, std::pmr::memory_resource *resource) {
+    BitImage image { 0, 0, 0, 0, 0, std::pmr::vector<std::uint64_t>(resource), {} };
+    image.width = width;
+    image.height = height;
+    image.word_columns = (width + 63) / 64 + padding_columns;
+    image.last_column_mask = (width % 64) ? ((std::uint64_t(1) << (width % 64)) - 1) : ~std::uint64_t(0);
+    image.words.resize(static_cast<std::size_t>(image.word_columns) * height);
+    return image;
+}
+
+BitImage BitImage::pack(const MonochromeImage &image, std::uint32_t padding_columns) {
+    auto packed = BitImage::create(image.width, image.height, padding_columns);
+    packed.text = image.text;
+
+    for(std::uint32_t y = 0; y < image.height; y++) {
+        const auto *row = image.pixels.data() + static_cast<std::size_t>(y) * image.width;
+        for(std::uint32_t x = 0; x < image.width; x++) {
+            if(row[x].intensity) {
+                packed.words[y + (x >> 6) * packed.height] |= std::uint64_t(1) << (x & 63);
+                packed.ink++;
+            }
+        }
+    }
+
+    return packed;
+}
+
+BitImage downsample(const BitImage &image, std::uint32_t padding_columns, std::pmr::memory_resource *resource) {
+    auto half = BitImage::create(image.width / 2, image.height / 2, padding_columns, resource);
+    half.text = image.text;
+
+    for(std::uint32_t y = 0; y < half.height; y++) {
+        for(std::uint32_t x = 0; x < half.width; x++) {
+            std::uint32_t block = image.get(x * 2, y * 2) + image.get(x * 2 + 1, y * 2) + image.get(x * 2, y * 2 + 1) + image.get(x * 2 + 1, y * 2 + 1);
+            if(block >= 2) {
+                half.words[y + (x >> 6) * half.height] |= std::uint64_t(1) << (x & 63);
+                half.ink++;
+            }
+        }
+    }
+
+    return half;
+}
+
+float match(const BitImage &image, const BitView &text, std::uint32_t x, std::uint32_t y) {
+    std::uint32_t pixels_compared;
+    return match_bounded(image, text, x, y, -1.0F, pixels_compared);
+}
+
+float match_bounded(const BitImage &image, const BitView &text, std::uint32_t x, std::uint32_t y, float score_to_beat, std::uint32_t &pixels_compared) {
+    static const MatchKernel count_misses = get_match_kernel();
+
+    pixels_compared = 0;
+    if(x > image.width || text.width > image.width - x || y > image.height || text.height > image.height - y || text.width == 0 || text.height == 0) {
+        return 0.0F;
+    }
+
+    std::uint32_t total = text.height * text.width;
+
+    // Find the fewest hits that beat the score, comparing the same way the score is computed
+    std::uint32_t miss_limit = total;
+    if(score_to_beat >= 0.0F) {
+        auto hits_needed = static_cast<std::uint32_t>(std::min(score_to_beat, 1.0F) * static_cast<float>(total));
+        while(hits_needed > 0 && static_cast<float>(hits_needed - 1) / total > score_to_beat) {
+            hits_needed--;
+        }
+        while(hits_needed <= total && !(static_cast<float>(hits_needed) / total > score_to_beat)) {
+            hits_needed++;
+        }
+        if(hits_needed > total) {
+            return 0.0F;
+        }
+        miss_limit = total - hits_needed;
+    }
+
+    std::uint32_t text_columns = (text.width + 63) / 64;
+    std::uint32_t rows_compared;
+    std::uint32_t misses = count_misses(image.words.data() + (x >> 6) * image.height + y, image.height, text.words, text.height, text_columns, text.last_column_mask, x & 63, miss_limit, rows_compared);
+
+    // Every word column is 64 pixels wide except for the last one
+    std::uint32_t full_columns = rows_compared / text.height;
+    std::uint32_t last_column_width = text.width - (text_columns - 1) * 64;
+    pixels_compared = full_columns * text.height * 64 - (full_columns == text_columns ? (64 - last_column_width) * text.height : 0);
+    if(full_columns < text_columns) {
+        pixels_compared += (rows_compared % text.height) * (full_columns + 1 == text_columns ? last_column_width : 64);
+    }
+
+    if(misses > miss_limit) {
+        return 0.0F;
+    }
+
+    std::uint32_t hits = total - misses;
+    return static_cast<float>(hits) / total;
+}
@@ -0,0 +1,151 @@
+#ifndef CARNAGE_REPORTER__BIT_IMAGE_HPP
+#define CARNAGE_REPORTER__BIT_IMAGE_HPP
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "image.hpp"
+
+/**
+ * A read-only view of a packed template. The words may belong to a BitImage or to memory the template was loaded into,
+ * such as a memory-mapped cache file. Templates have no padding columns.
+ */
+struct BitView {
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+
+    /** Mask of the valid bits in the last word column */
+    std::uint64_t last_column_mask = 0;
+
+    /** Number of set pixels */
+    std::uint32_t ink = 0;
+
+    /** Words, indexed by row + word column * height */
+    const std::uint64_t *words = nullptr;
+
+    /** Text this template was rendered from */
+    std::string_view text;
+
+    /**
+     * Get whether or not a pixel is set
+     * @param x x coordinate
+     * @param y y coordinate
+     * @return  true if set
+     */
+    bool get(std::uint32_t x, std::uint32_t y) const {
+        return (this->words[y + (x >> 6) * this->height] >> (x & 63)) & 1;
+    }
+};
+
+/**
+ * A thresholded image packed to one bit per pixel. Each row is split into 64-pixel words where bit n of a word is pixel
+ * n of that span, and the words are stored one word column at a time so the same word of consecutive rows is
+ * contiguous. Bits past the width of the image are always 0.
+ */
+struct BitImage {
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+
+    /** Number of 64-pixel word columns, including any padding columns */
+    std::uint32_t word_columns = 0;
+
+    /** Mask of the valid bits in the last word column that holds pixels */
+    std::uint64_t last_column_mask = 0;
+
+    /** Number of set pixels */
+    std::uint32_t ink = 0;
+
+    /** Words, indexed by row + word column * height */
+    std::pmr::vector<std::uint64_t> words;
+
+    /** Text this image was rendered from, if it is a template */
+    std::string text;
+
+    /**
+     * Get whether or not a pixel is set
+     * @param x x coordinate
+     * @param y y coordinate
+     * @return  true if set
+     */
+    bool get(std::uint32_t x, std::uint32_t y) const {
+        return (this->words[y + (x >> 6) * this->height] >> (x & 63)) & 1;
+    }
+
+    /**
+     * View the image as a template
+     */
+    operator BitView() const {
+        return BitView { this->width, this->height, this->last_column_mask, this->ink, this->words.data(), this->text };
+    }
+
+    /**
+     * Create a blank image
+     * @param width           width in pixels
+     * @param height          height in pixels
+     * @param padding_columns number of extra zeroed word columns to add to the right
+     * @param resource        where to allocate the words
+     * @return                blank image
+     */
+    static BitImage create(std::uint32_t width, std::uint32_t height, std::uint32_t padding_columns = 0, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    /**
+     * Pack a thresholded monochrome image
+     * @param image           image where every pixel is either 0x00 or 0xFF
+     * @param padding_columns number of extra zeroed word columns to add to the right
+     * @return                packed image
+     */
+    static BitImage pack(const MonochromeImage &image, std::uint32_t padding_columns = 0);
+};
+
+/**
+ * Halve the size of an image. Each pixel of the new image covers a 2x2 block and is set if at least two of the four
+ * pixels in the block are set.
+ * @param image           image to shrink
+ * @param padding_columns number of extra zeroed word columns to add to the right
+ * @param resource        where to allocate the words
+ * @return                image at half size
+ */
+BitImage downsample(const BitImage &image, std::uint32_t padding_columns = 0, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+/**
+ * Count the set bits of a word
+ * @param word word
+ * @return     number of set bits
+ */
+inline std::uint32_t popcount64(std::uint64_t word) {
+    #ifdef __GNUC__
+    return static_cast<std::uint32_t>(__builtin_popcountll(word));
+    #else
+    word = word - ((word >> 1) & 0x5555555555555555);
+    word = (word & 0x3333333333333333) + ((word >> 2) & 0x3333333333333333);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0F;
+    return static_cast<std::uint32_t>((word * 0x0101010101010101) >> 56);
+    #endif
+}
+
+/**
+ * Find how well a template matches an image at a given position
+ * @param image image to search; must have at least one padding column
+ * @param text  template to match
+ * @param x     left of the template in the image
+ * @param y     top of the template in the image
+ * @return      fraction of pixels that match, or 0 if the template does not fit
+ */
+float match(const BitImage &image, const BitView &text, std::uint32_t x, std::uint32_t y);
+
+/**
+ * Find how well a template matches an image at a given position, giving up as soon as it can't beat a score
+ * @param image           image to search; must have at least one padding column
+ * @param text            template to match
+ * @param x               left of the template in the image
+ * @param y               top of the template in the image
+ * @param score_to_beat   score the match has to be greater than to be useful (negative to always finish)
+ * @param pixels_compared set to the number of pixels compared
+ * @return                same as match() if that is greater than score_to_beat; otherwise some score that is not
+ */
+float match_bounded(const BitImage &image, const BitView &text, std::uint32_t x, std::uint32_t y, float score_to_beat, std::uint32_t &pixels_compared);
+
+#endif
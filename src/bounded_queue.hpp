@@ -0,0 +1,138 @@
+#ifndef CARNAGE_REPORTER__BOUNDED_QUEUE_HPP
+#define CARNAGE_REPORTER__BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+
+/**
+ * A fixed-size ring of items passed between threads without a lock. Any number of threads can push and pop at once:
+ * each slot has a sequence number saying whose turn it is, and a thread claims a slot by advancing the head or tail
+ * with a compare-and-swap. A thread that finds the queue full or empty backs off, briefly spinning and then sleeping,
+ * which is cheap next to how long each item takes to work on.
+ */
+template<typename Item> class BoundedQueue {
+public:
+    /**
+     * Add an item, waiting for room
+     * @param item item to add
+     */
+    void push(Item item) {
+        for(unsigned int attempt = 0; !this->try_push(item); attempt++) {
+            back_off(attempt);
+        }
+    }
+
+    /**
+     * Take the oldest item, waiting for one
+     * @return item, or std::nullopt if the queue is closed and empty
+     */
+    std::optional<Item> pop() {
+        for(unsigned int attempt = 0; ; attempt++) {
+            // Check for closing first, so an item pushed right before closing is still seen
+            bool closed = this->closed.load(std::memory_order_acquire);
+            if(auto item = this->try_pop()) {
+                return item;
+            }
+            if(closed) {
+                return std::nullopt;
+            }
+            back_off(attempt);
+        }
+    }
+
+    /**
+     * Say that nothing more will be pushed
+     */
+    void close() {
+        this->closed.store(true, std::memory_order_release);
+    }
+
+    /**
+     * Make a queue
+     * @param capacity most items it holds at once (rounded up to a power of two)
+     */
+    BoundedQueue(std::size_t capacity) {
+        std::size_t size = 1;
+        while(size < capacity) {
+            size *= 2;
+        }
+        this->mask = size - 1;
+        this->slots = std::make_unique<Slot[]>(size);
+        for(std::size_t i = 0; i < size; i++) {
+            this->slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct Slot {
+        /** Equal to the position a pusher can fill this slot at, or one past the position a popper can empty it at */
+        std::atomic<std::size_t> sequence;
+        std::optional<Item> item;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t mask;
+
+    // Pushers and poppers each get their own cache line
+    alignas(64) std::atomic<std::size_t> tail = 0;
+    alignas(64) std::atomic<std::size_t> head = 0;
+    alignas(64) std::atomic<bool> closed = false;
+
+    bool try_push(Item &item) {
+        std::size_t position = this->tail.load(std::memory_order_relaxed);
+        while(true) {
+            auto &slot = this->slots[position & this->mask];
+            auto difference = static_cast<std::ptrdiff_t>(slot.sequence.load(std::memory_order_acquire) - position);
+            if(difference == 0) {
+                if(this->tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.item.emplace(std::move(item));
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(difference < 0) {
+                return false;
+            }
+            else {
+                position = this->tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::optional<Item> try_pop() {
+        std::size_t position = this->head.load(std::memory_order_relaxed);
+        while(true) {
+            auto &slot = this->slots[position & this->mask];
+            auto difference = static_cast<std::ptrdiff_t>(slot.sequence.load(std::memory_order_acquire) - (position + 1));
+            if(difference == 0) {
+                if(this->head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    std::optional<Item> item = std::move(slot.item);
+                    slot.item.reset();
+                    slot.sequence.store(position + this->mask + 1, std::memory_order_release);
+                    return item;
+                }
+            }
+            else if(difference < 0) {
+                return std::nullopt;
+            }
+            else {
+                position = this->head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static void back_off(unsigned int attempt) {
+        if(attempt < 64) {
+            std::this_thread::yield();
+        }
+        else {
+            std::this_thread::sleep_for(std::chrono::microseconds(attempt < 128 ? 50 : 500));
+        }
+    }
+};
+
+#endif
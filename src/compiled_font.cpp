@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "compiled_font.hpp"
+
+static constexpr char COMPILED_FONT_MAGIC[8] = { 'C', 'R', 'F', 'O', 'N', 'T', 0, 0 };
+static constexpr std::uint32_t COMPILED_FONT_VERSION = 2;
+static constexpr std::uint32_t COMPILED_FONT_BYTE_ORDER = 0x01020304;
+static constexpr std::size_t GLYPH_COUNT = 256;
+static constexpr std::uint64_t CACHE_LINE = 64;
+
+/**
+ * Copy a glyph bitmap into a template a row at a time. Parts of the glyph outside the template are clipped, and the
+ * glyph overwrites whatever was already under it, blank pixels included.
+ * @param image  template
+ * @param rows   first row of the bitmap in the atlas
+ * @param width  width of the bitmap
+ * @param height height of the bitmap
+ * @param left   column of the template the left of the bitmap lands on; may be negative
+ * @param top    row of the template the top of the bitmap lands on; may be negative
+ */
+static void blit(BitImage &image, const std::uint64_t *rows, std::int64_t width, std::int64_t height, std::int64_t left, std::int64_t top) {
+    std::int64_t first_x = std::max<std::int64_t>(0, -left);
+    std::int64_t last_x = std::min<std::int64_t>(width, static_cast<std::int64_t>(image.width) - left);
+    std::int64_t first_y = std::max<std::int64_t>(0, -top);
+    std::int64_t last_y = std::min<std::int64_t>(height, static_cast<std::int64_t>(image.height) - top);
+    if(first_x >= last_x || first_y >= last_y) {
+        return;
+    }
+
+    std::size_t stride = static_cast<std::size_t>((width + 63) / 64);
+    for(std::int64_t y = first_y; y < last_y; y++) {
+        const auto *row = rows + static_cast<std::size_t>(y) * stride;
+        auto *column = image.words.data() + (y + top);
+
+        // Fill the template a word at a time, pulling each run of bits out of at most two words of the row
+        for(std::int64_t x = left + first_x; x < left + last_x;) {
+            std::uint64_t shift = static_cast<std::uint64_t>(x) & 63;
+            std::uint64_t count = std::min<std::uint64_t>(64 - shift, static_cast<std::uint64_t>(left + last_x - x));
+            std::uint64_t source = static_cast<std::uint64_t>(x - left);
+            std::uint64_t source_shift = source & 63;
+
+            std::uint64_t bits = row[source >> 6] >> source_shift;
+            if(source_shift + count > 64) {
+                bits |= row[(source >> 6) + 1] << (64 - source_shift);
+            }
+            std::uint64_t mask = count == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << count) - 1;
+
+            auto &word = column[static_cast<std::size_t>(x >> 6) * image.height];
+            word = (word & ~(mask << shift)) | ((bits & mask) << shift);
+            x += count;
+        }
+    }
+}
+
+/**
+ * Render text and pack it into a template. This follows draw_text() exactly, including glyphs that overlap or hang off
+ * the edge, so the templates come out the same.
+ * @param text              text to render
+ * @param ascending_height  height of the font above the baseline
+ * @param descending_height height of the font below the baseline
+ * @param metrics           glyph metrics
+ * @param atlas             glyph bitmaps
+ * @return                  template
+ */
+static BitImage render(const char *text, std::int16_t ascending_height, std::int16_t descending_height, const CompiledGlyphMetrics &metrics, const std::uint64_t *atlas) {
+    std::uint32_t width = 0;
+    std::uint32_t height = ascending_height + descending_height;
+    for(const char *c = text; *c; c++) {
+        width += metrics.advances[static_cast<std::uint8_t>(*c)];
+    }
+
+    auto drawn_text = BitImage::create(width, height);
+    drawn_text.text = text;
+
+    std::uint32_t x_cursor = 0;
+    for(const char *c = text; *c; c++) {
+        auto glyph = static_cast<std::uint8_t>(*c);
+        auto bitmap_width = metrics.bitmap_widths[glyph];
+        auto bitmap_height = metrics.bitmap_heights[glyph];
+
+        // draw_text() positions glyphs with unsigned arithmetic, so a cursor past 2^31 wraps around to the left
+        if(bitmap_width > 0 && bitmap_height > 0 && metrics.atlas_offsets[glyph] != CompiledGlyphMetrics::NO_BITMAP) {
+            blit(drawn_text, atlas + metrics.atlas_offsets[glyph], bitmap_width, bitmap_height, static_cast<std::int32_t>(x_cursor), ascending_height - metrics.bitmap_origins_y[glyph]);
+        }
+        x_cursor += metrics.advances[glyph];
+    }
+
+    for(auto word : drawn_text.words) {
+        drawn_text.ink += popcount64(word);
+    }
+
+    return drawn_text;
+}
+
+CompiledFont CompiledFont::compile(const FontTag &tag) {
+    CompiledFontHeader header = {};
+    std::memcpy(header.magic, COMPILED_FONT_MAGIC, sizeof(header.magic));
+    header.version = COMPILED_FONT_VERSION;
+    header.byte_order = COMPILED_FONT_BYTE_ORDER;
+    header.source_hash = tag.source_hash;
+    header.ascending_height = swap_endian(tag.font.ascending_height);
+    header.descending_height = swap_endian(tag.font.descending_height);
+
+    // Convert the glyphs to native byte order, and threshold and pack their bitmaps the same way draw_text() and
+    // filter_monochrome() would
+    CompiledGlyphMetrics metrics = {};
+    std::vector<std::uint64_t> atlas;
+    for(std::size_t i = 0; i < GLYPH_COUNT; i++) {
+        metrics.atlas_offsets[i] = CompiledGlyphMetrics::NO_BITMAP;
+        if(i >= tag.characters.size()) {
+            continue;
+        }
+
+        const auto &c = tag.characters[i];
+        auto bitmap_width = swap_endian(c.bitmap_width);
+        auto bitmap_height = swap_endian(c.bitmap_height);
+        auto pixels_offset = swap_endian(c.pixels_offset);
+        metrics.advances[i] = swap_endian(c.character_width);
+        metrics.bitmap_widths[i] = bitmap_width;
+        metrics.bitmap_heights[i] = bitmap_height;
+        metrics.bitmap_origins_y[i] = swap_endian(c.bitmap_origin_y);
+
+        if(bitmap_width <= 0 || bitmap_height <= 0 || pixels_offset > tag.pixels.size() || static_cast<std::size_t>(bitmap_width) * bitmap_height > tag.pixels.size() - pixels_offset) {
+            continue;
+        }
+
+        std::size_t stride = (static_cast<std::size_t>(bitmap_width) + 63) / 64;
+        metrics.atlas_offsets[i] = static_cast<std::uint32_t>(atlas.size());
+        atlas.resize(atlas.size() + stride * bitmap_height);
+        auto *rows = atlas.data() + metrics.atlas_offsets[i];
+        const auto *pixels = tag.pixels.data() + pixels_offset;
+        for(std::size_t y = 0; y < static_cast<std::size_t>(bitmap_height); y++) {
+            for(std::size_t x = 0; x < static_cast<std::size_t>(bitmap_width); x++) {
+                if(static_cast<std::uint8_t>(static_cast<std::uint32_t>(pixels[x + y * bitmap_width].intensity) * 3 / 4) >= MONOCHROME_THRESHOLD) {
+                    rows[y * stride + (x >> 6)] |= std::uint64_t(1) << (x & 63);
+                }
+            }
+        }
+    }
+    header.atlas_word_count = atlas.size();
+
+    // Render the same tables the recognizer looks for
+    std::vector<BitImage> templates;
+    for(char c : std::string("0123456789-")) {
+        char v[2] = { c, 0 };
+        templates.emplace_back(render(v, header.ascending_height, header.descending_height, metrics, atlas.data()));
+    }
+    header.number_count = static_cast<std::uint32_t>(templates.size());
+    for(std::size_t i = ' '; i < 0x7F; i++) {
+        if(metrics.advances[i]) {
+            char v[2] = { static_cast<char>(i), 0 };
+            templates.emplace_back(render(v, header.ascending_height, header.descending_height, metrics, atlas.data()));
+        }
+    }
+    header.character_count = static_cast<std::uint32_t>(templates.size()) - header.number_count;
+
+    std::vector<CompiledTemplate> compiled_templates;
+    for(auto &t : templates) {
+        auto &compiled = compiled_templates.emplace_back();
+        compiled.width = t.width;
+        compiled.height = t.height;
+        compiled.ink = t.ink;
+        compiled.character = t.text[0];
+        compiled.last_column_mask = t.last_column_mask;
+        compiled.words_offset = header.word_count;
+        header.word_count += t.words.size();
+    }
+
+    // Lay out the file, starting every section on a cache line
+    auto align = [](std::uint64_t offset) -> std::uint64_t {
+        return (offset + CACHE_LINE - 1) & ~(CACHE_LINE - 1);
+    };
+    header.metrics_offset = align(sizeof(header));
+    header.atlas_offset = align(header.metrics_offset + sizeof(metrics));
+    header.templates_offset = align(header.atlas_offset + atlas.size() * sizeof(std::uint64_t));
+    header.words_offset = align(header.templates_offset + compiled_templates.size() * sizeof(CompiledTemplate));
+    header.file_size = header.words_offset + header.word_count * sizeof(std::uint64_t);
+
+    CompiledFont font;
+    font.owned.resize(header.file_size + CACHE_LINE);
+    auto *output = font.owned.data() + (-reinterpret_cast<std::uintptr_t>(font.owned.data()) & (CACHE_LINE - 1));
+    std::memcpy(output, &header, sizeof(header));
+    std::memcpy(output + header.metrics_offset, &metrics, sizeof(metrics));
+    std::memcpy(output + header.atlas_offset, atlas.data(), atlas.size() * sizeof(std::uint64_t));
+    std::memcpy(output + header.templates_offset, compiled_templates.data(), compiled_templates.size() * sizeof(CompiledTemplate));
+    for(std::size_t i = 0; i < templates.size(); i++) {
+        auto &words = templates[i].words;
+        std::memcpy(output + header.words_offset + compiled_templates[i].words_offset * sizeof(std::uint64_t), words.data(), words.size() * sizeof(std::uint64_t));
+    }
+
+    font.bind(output, header.file_size);
+    return font;
+}
+
+std::optional<CompiledFont> CompiledFont::load(const char *path, std::uint64_t source_hash) {
+    CompiledFont font;
+    if(!font.mapped.open(path) || !font.bind(font.mapped.data(), font.mapped.size()) || font.header->source_hash != source_hash) {
+        return std::nullopt;
+    }
+    return font;
+}
+
+std::optional<CompiledFont> CompiledFont::from_memory(const std::byte *data, std::size_t size) {
+    CompiledFont font;
+    if(!font.bind(data, size)) {
+        return std::nullopt;
+    }
+    return font;
+}
+
+bool CompiledFont::save(const char *path) const {
+    return replace_file(path, this->data, this->size);
+}
+
+BitImage CompiledFont::draw(const char *text) const {
+    return render(text, this->header->ascending_height, this->header->descending_height, *this->metrics, this->atlas);
+}
+
+bool CompiledFont::bind(const std::byte *data, std::size_t size) {
+    if(!data || size < sizeof(CompiledFontHeader)) {
+        return false;
+    }
+
+    const auto *header = reinterpret_cast<const CompiledFontHeader *>(data);
+    if(std::memcmp(header->magic, COMPILED_FONT_MAGIC, sizeof(header->magic)) != 0 || header->version != COMPILED_FONT_VERSION || header->byte_order != COMPILED_FONT_BYTE_ORDER || header->file_size != size) {
+        return false;
+    }
+
+    // Every section has to be aligned and lie within the file
+    auto section_fits = [&size](std::uint64_t offset, std::uint64_t count, std::uint64_t element_size) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / element_size;
+    };
+    std::uint64_t template_count = static_cast<std::uint64_t>(header->number_count) + header->character_count;
+    if(!section_fits(header->metrics_offset, 1, sizeof(CompiledGlyphMetrics)) ||
+       !section_fits(header->atlas_offset, header->atlas_word_count, sizeof(std::uint64_t)) ||
+       !section_fits(header->templates_offset, template_count, sizeof(CompiledTemplate)) ||
+       !section_fits(header->words_offset, header->word_count, sizeof(std::uint64_t))) {
+        return false;
+    }
+
+    // Every bitmap has to lie within the atlas
+    const auto *metrics = reinterpret_cast<const CompiledGlyphMetrics *>(data + header->metrics_offset);
+    for(std::size_t i = 0; i < GLYPH_COUNT; i++) {
+        auto bitmap_width = metrics->bitmap_widths[i];
+        auto bitmap_height = metrics->bitmap_heights[i];
+        auto atlas_offset = metrics->atlas_offsets[i];
+        if(bitmap_width <= 0 || bitmap_height <= 0 || atlas_offset == CompiledGlyphMetrics::NO_BITMAP) {
+            continue;
+        }
+        std::uint64_t word_count = static_cast<std::uint64_t>((bitmap_width + 63) / 64) * bitmap_height;
+        if(atlas_offset > header->atlas_word_count || word_count > header->atlas_word_count - atlas_offset) {
+            return false;
+        }
+    }
+
+    const auto *templates = reinterpret_cast<const CompiledTemplate *>(data + header->templates_offset);
+    const auto *words = reinterpret_cast<const std::uint64_t *>(data + header->words_offset);
+    std::vector<BitView> views;
+    for(std::uint64_t i = 0; i < template_count; i++) {
+        const auto &t = templates[i];
+        std::uint64_t word_count = static_cast<std::uint64_t>((t.width + 63) / 64) * t.height;
+        if(t.words_offset > header->word_count || word_count > header->word_count - t.words_offset) {
+            return false;
+        }
+        views.push_back(BitView { t.width, t.height, t.last_column_mask, t.ink, words + t.words_offset, std::string_view(&t.character, 1) });
+    }
+
+    this->data = data;
+    this->size = size;
+    this->header = header;
+    this->metrics = metrics;
+    this->atlas = reinterpret_cast<const std::uint64_t *>(data + header->atlas_offset);
+    this->numbers.assign(views.begin(), views.begin() + header->number_count);
+    this->characters.assign(views.begin() + header->number_count, views.end());
+    return true;
+}
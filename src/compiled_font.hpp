@@ -0,0 +1,208 @@
+#ifndef CARNAGE_REPORTER__COMPILED_FONT_HPP
+#define CARNAGE_REPORTER__COMPILED_FONT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "font.hpp"
+#include "bit_image.hpp"
+#include "mapped_file.hpp"
+
+/**
+ * Metrics of every glyph of a compiled font, in native byte order. Each metric is its own array indexed by character,
+ * so measuring a string only touches the advances.
+ */
+struct CompiledGlyphMetrics {
+    std::int16_t advances[256];
+    std::int16_t bitmap_widths[256];
+    std::int16_t bitmap_heights[256];
+    std::int16_t bitmap_origins_y[256];
+
+    /** Offset of the first row of each bitmap, in words from the start of the atlas, or NO_BITMAP */
+    std::uint32_t atlas_offsets[256];
+
+    /** Atlas offset of a glyph with nothing to draw */
+    static constexpr std::uint32_t NO_BITMAP = 0xFFFFFFFF;
+};
+static_assert(sizeof(CompiledGlyphMetrics) == 0xC00);
+
+/**
+ * A single-character template of a compiled font
+ */
+struct CompiledTemplate {
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t ink;
+    char character;
+    char padding[0x3];
+    std::uint64_t last_column_mask;
+
+    /** Offset of the first word, in words from the start of the words section */
+    std::uint64_t words_offset;
+};
+static_assert(sizeof(CompiledTemplate) == 0x20);
+
+/**
+ * Start of a compiled font file. Offsets are in bytes from the start of the file, and everything is in the byte order
+ * of the machine that wrote it. Sections start on a cache line so glyphs and templates never share one with anything
+ * else.
+ */
+struct CompiledFontHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t source_hash;
+    std::uint64_t file_size;
+    std::int16_t ascending_height;
+    std::int16_t descending_height;
+    std::uint32_t number_count;
+    std::uint32_t character_count;
+    std::uint32_t padding;
+    std::uint64_t atlas_word_count;
+    std::uint64_t word_count;
+
+    /** CompiledGlyphMetrics */
+    std::uint64_t metrics_offset;
+
+    /**
+     * atlas_word_count 64-bit words of glyph bitmaps, already thresholded. Each bitmap is stored row by row, each row
+     * taking (bitmap width + 63) / 64 words with pixel n of the row in bit n % 64 of word n / 64.
+     */
+    std::uint64_t atlas_offset;
+
+    /** number_count digit templates followed by character_count printable ASCII templates */
+    std::uint64_t templates_offset;
+
+    /** word_count 64-bit words of template pixels */
+    std::uint64_t words_offset;
+};
+static_assert(sizeof(CompiledFontHeader) == 0x60);
+
+/**
+ * A font with its glyphs thresholded and its single-character templates already packed. It can be saved to a file and
+ * later mapped straight into memory, so every process reading with the same font shares one copy of it and nothing has
+ * to be parsed or rendered again.
+ */
+class CompiledFont {
+public:
+    /**
+     * Compile a font tag
+     * @param tag font tag
+     * @return    compiled font
+     */
+    static CompiledFont compile(const FontTag &tag);
+
+    /**
+     * Map a compiled font file
+     * @param path        path to the file
+     * @param source_hash hash of the font tag the file has to have been compiled from
+     * @return            compiled font, or nothing if the file is missing, invalid, or was compiled from something else
+     */
+    static std::optional<CompiledFont> load(const char *path, std::uint64_t source_hash);
+
+    /**
+     * Use a compiled font that is already in memory, such as one built into the program
+     * @param data contents of a compiled font file; must stay valid for as long as the font is used
+     * @param size size of the contents in bytes
+     * @return     compiled font, or nothing if the contents are invalid or were compiled for another byte order
+     */
+    static std::optional<CompiledFont> from_memory(const std::byte *data, std::size_t size);
+
+    /**
+     * Write the compiled font to a file. The file is replaced in one step, so processes that have the old one mapped
+     * are not disturbed.
+     * @param path path to the file
+     * @return     true if the file was written
+     */
+    bool save(const char *path) const;
+
+    /**
+     * Get the hash of the font tag this was compiled from
+     * @return hash
+     */
+    std::uint64_t get_source_hash() const {
+        return this->header->source_hash;
+    }
+
+    /**
+     * Get the contents of the compiled font file
+     * @return contents
+     */
+    const std::byte *get_data() const {
+        return this->data;
+    }
+
+    /**
+     * Get the size of the compiled font file
+     * @return size in bytes
+     */
+    std::size_t get_size() const {
+        return this->size;
+    }
+
+    /**
+     * Render text and pack it into a template; identical to thresholding and packing draw_text()
+     * @param text text to render
+     * @return     template
+     */
+    BitImage draw(const char *text) const;
+
+    /**
+     * Get the height of the font above the baseline
+     * @return ascending height
+     */
+    std::int16_t get_ascending_height() const {
+        return this->header->ascending_height;
+    }
+
+    /**
+     * Get the templates of the digits 0-9 followed by a hyphen
+     * @return templates
+     */
+    const std::vector<BitView> &get_numbers() const {
+        return this->numbers;
+    }
+
+    /**
+     * Get the templates of every printable ASCII character present in the font
+     * @return templates
+     */
+    const std::vector<BitView> &get_characters() const {
+        return this->characters;
+    }
+
+    CompiledFont(const CompiledFont &) = delete;
+    CompiledFont &operator=(const CompiledFont &) = delete;
+    CompiledFont(CompiledFont &&) = default;
+    CompiledFont &operator=(CompiledFont &&) = default;
+
+private:
+    CompiledFont() = default;
+
+    /** Contents of the file if it was compiled in this process, with room to start them on a cache line */
+    std::vector<std::byte> owned;
+
+    /** Contents of the file if it was loaded */
+    MappedFile mapped;
+
+    const std::byte *data = nullptr;
+    std::size_t size = 0;
+    const CompiledFontHeader *header = nullptr;
+    const CompiledGlyphMetrics *metrics = nullptr;
+    const std::uint64_t *atlas = nullptr;
+
+    std::vector<BitView> numbers;
+    std::vector<BitView> characters;
+
+    /**
+     * Check the contents and point everything into them
+     * @param data contents
+     * @param size size of the contents in bytes
+     * @return     true if the contents are valid
+     */
+    bool bind(const std::byte *data, std::size_t size);
+};
+
+#endif
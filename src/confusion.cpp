@@ -0,0 +1,118 @@
+#include <algorithm>
+
+#include "confusion.hpp"
+
+/**
+ * Find the pixels two glyphs of the same height disagree on. Only the columns both glyphs cover are compared, since
+ * anything past the narrower glyph belongs to whatever is read after it.
+ * @param glyph_a first glyph
+ * @param glyph_b second glyph
+ * @param ink     set to the number of pixels compared that either glyph sets
+ * @return        differing pixels, each set if glyph_a has it set
+ */
+static std::vector<ConfusablePixel> differing_pixels(const BitView &glyph_a, const BitView &glyph_b, std::uint32_t &ink) {
+    std::vector<ConfusablePixel> pixels;
+    std::uint32_t width = std::min(glyph_a.width, glyph_b.width);
+    ink = 0;
+    for(std::uint32_t y = 0; y < glyph_a.height; y++) {
+        for(std::uint32_t x = 0; x < width; x++) {
+            bool set_a = glyph_a.get(x, y);
+            bool set_b = glyph_b.get(x, y);
+            ink += set_a || set_b;
+            if(set_a != set_b) {
+                pixels.push_back(ConfusablePixel { x, y, set_a });
+            }
+        }
+    }
+    return pixels;
+}
+
+ConfusionTable::ConfusionTable(const std::vector<BitView> &glyphs) : confusables(256), advances(256) {
+    for(auto &glyph : glyphs) {
+        this->advances[static_cast<std::uint8_t>(glyph.text[0])] = glyph.width;
+    }
+
+    // Blank space agrees with any glyph, so only the pixels that are set in one glyph or the other count
+    auto comparable = [](const BitView &glyph_a, const BitView &glyph_b) {
+        return glyph_a.height == glyph_b.height && glyph_a.width > 0 && glyph_b.width > 0;
+    };
+    auto difference = [](const std::vector<ConfusablePixel> &pixels, std::uint32_t ink) {
+        return ink == 0 ? 0.0F : static_cast<float>(pixels.size()) / ink;
+    };
+
+    // Whatever the font, the pairs that used to be fixed by hand are confusable, so any pair at most as different as
+    // the most different of them is, too
+    auto find_glyph = [&glyphs](char character) -> const BitView * {
+        for(auto &glyph : glyphs) {
+            if(glyph.text[0] == character) {
+                return &glyph;
+            }
+        }
+        return nullptr;
+    };
+    auto seed_pair = [](char first, char second) {
+        for(auto &pair : SEED_PAIRS) {
+            if(pair[0] == first && pair[1] == second) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for(auto &pair : SEED_PAIRS) {
+        const auto *glyph_a = find_glyph(pair[0]);
+        const auto *glyph_b = find_glyph(pair[1]);
+        if(glyph_a && glyph_b && comparable(*glyph_a, *glyph_b)) {
+            std::uint32_t ink;
+            auto pixels = differing_pixels(*glyph_a, *glyph_b, ink);
+            this->maximum_difference = std::max(this->maximum_difference, difference(pixels, ink));
+        }
+    }
+
+    for(std::size_t a = 0; a < glyphs.size(); a++) {
+        for(std::size_t b = a + 1; b < glyphs.size(); b++) {
+            const auto &glyph_a = glyphs[a];
+            const auto &glyph_b = glyphs[b];
+            if(!comparable(glyph_a, glyph_b)) {
+                continue;
+            }
+
+            // Identical glyphs can't be told apart, and very different ones aren't confused
+            std::uint32_t ink;
+            auto pixels = differing_pixels(glyph_a, glyph_b, ink);
+            if(pixels.empty() || difference(pixels, ink) > this->maximum_difference) {
+                continue;
+            }
+
+            char character_a = glyph_a.text[0];
+            char character_b = glyph_b.text[0];
+            this->confusables[static_cast<std::uint8_t>(character_a)].push_back(Confusable { character_b, pixels, seed_pair(character_a, character_b) });
+            for(auto &pixel : pixels) {
+                pixel.set = !pixel.set;
+            }
+            this->confusables[static_cast<std::uint8_t>(character_b)].push_back(Confusable { character_a, std::move(pixels), seed_pair(character_b, character_a) });
+        }
+    }
+}
+
+char ConfusionTable::disambiguate(const BitImage &image, char character, std::uint32_t x, std::uint32_t y) const {
+    char best_character = character;
+    std::int64_t best_margin = 0;
+
+    for(auto &confusable : this->confusables[static_cast<std::uint8_t>(character)]) {
+        // Each pixel matches exactly one of the two glyphs
+        std::int64_t margin = 0;
+        for(auto &pixel : confusable.pixels) {
+            std::uint32_t image_x = x + pixel.x;
+            std::uint32_t image_y = y + pixel.y;
+            bool set = image_x < image.width && image_y < image.height && image.get(image_x, image_y);
+            margin += set == pixel.set ? -1 : 1;
+        }
+
+        if(margin > best_margin || (margin == best_margin && best_character == character && confusable.wins_ties)) {
+            best_margin = margin;
+            best_character = confusable.character;
+        }
+    }
+
+    return best_character;
+}
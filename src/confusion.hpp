@@ -0,0 +1,88 @@
+#ifndef CARNAGE_REPORTER__CONFUSION_HPP
+#define CARNAGE_REPORTER__CONFUSION_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "bit_image.hpp"
+
+/**
+ * A pixel that is set in one glyph of a confusable pair and clear in the other
+ */
+struct ConfusablePixel {
+    std::uint32_t x;
+    std::uint32_t y;
+
+    /** Whether the glyph the pair is listed under has this pixel set */
+    bool set;
+};
+
+/**
+ * A glyph that is easily mistaken for another, and the pixels that tell them apart
+ */
+struct Confusable {
+    char character;
+    std::vector<ConfusablePixel> pixels;
+
+    /** Whether this glyph is picked when both match equally well, as the second glyph of a seed pair is */
+    bool wins_ties;
+};
+
+/**
+ * Every pair of glyphs in a font that differ on only a few pixels. Once a glyph has been read at a position, checking
+ * just those pixels is enough to tell which glyph of the pair is really there.
+ */
+class ConfusionTable {
+public:
+    /**
+     * Pairs that used to be the only ones checked. However different they are in a font is how different any other pair
+     * may be and still be confusable. As before, the second glyph of each pair wins ties.
+     */
+    static constexpr char SEED_PAIRS[][2] = { {'l', 'i'}, {'I', 'i'}, {'I', 'l'}, {'2', 'Z'}, {'a', 'e'}, {'n', 'm'} };
+
+    /**
+     * Get which glyph is really at a position, given one that was read there
+     * @param image     image being read
+     * @param character glyph that was read
+     * @param x         left of the glyph in the image
+     * @param y         top of the glyph in the image
+     * @return          character, or a glyph it is confusable with that matches more of the pixels telling them apart
+     */
+    char disambiguate(const BitImage &image, char character, std::uint32_t x, std::uint32_t y) const;
+
+    /**
+     * Get how far reading moves past a glyph
+     * @param character glyph
+     * @return          width of the glyph, or 0 if the font doesn't have it
+     */
+    std::uint32_t get_advance(char character) const {
+        return this->advances[static_cast<std::uint8_t>(character)];
+    }
+
+    /**
+     * Get the largest fraction of the pixels either of two glyphs sets, in the columns both cover, that can differ for
+     * them to be confusable
+     * @return fraction
+     */
+    float get_maximum_difference() const {
+        return this->maximum_difference;
+    }
+
+    /**
+     * Find every confusable pair of glyphs
+     * @param glyphs glyph table
+     */
+    ConfusionTable(const std::vector<BitView> &glyphs);
+
+private:
+    /** Confusable glyphs of each character */
+    std::vector<std::vector<Confusable>> confusables;
+
+    /** Width of each glyph */
+    std::vector<std::uint32_t> advances;
+
+    /** Most different the seed pairs are in this font */
+    float maximum_difference = 0.0F;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "correlation.hpp"
+
+/** Rough cost of one complex butterfly relative to matching one packed template word */
+static constexpr double BUTTERFLY_COST = 4.0;
+
+static std::size_t next_power_of_two(std::size_t value) {
+    std::size_t power = 1;
+    while(power < value) {
+        power <<= 1;
+    }
+    return power;
+}
+
+static std::size_t log2_of(std::size_t power) {
+    std::size_t log = 0;
+    while((std::size_t(1) << log) < power) {
+        log++;
+    }
+    return log;
+}
+
+void fft(std::complex<double> *data, std::size_t size, bool inverse) {
+    // Bit reversal permutation
+    for(std::size_t i = 1, j = 0; i < size; i++) {
+        std::size_t bit = size >> 1;
+        for(; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if(i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    // Butterflies
+    const double pi = std::acos(-1.0);
+    for(std::size_t length = 2; length <= size; length <<= 1) {
+        double angle = 2.0 * pi / static_cast<double>(length) * (inverse ? 1.0 : -1.0);
+        std::complex<double> step(std::cos(angle), std::sin(angle));
+        for(std::size_t start = 0; start < size; start += length) {
+            std::complex<double> twiddle(1.0, 0.0);
+            for(std::size_t k = 0; k < length / 2; k++) {
+                auto even = data[start + k];
+                auto odd = data[start + k + length / 2] * twiddle;
+                data[start + k] = even + odd;
+                data[start + k + length / 2] = even - odd;
+                twiddle *= step;
+            }
+        }
+    }
+}
+
+// Transform every row, then every column
+static void fft_2d(std::pmr::vector<std::complex<double>> &data, std::size_t width, std::size_t height, bool inverse) {
+    for(std::size_t y = 0; y < height; y++) {
+        fft(data.data() + y * width, width, inverse);
+    }
+
+    std::pmr::vector<std::complex<double>> column(height, data.get_allocator());
+    for(std::size_t x = 0; x < width; x++) {
+        for(std::size_t y = 0; y < height; y++) {
+            column[y] = data[x + y * width];
+        }
+        fft(column.data(), height, inverse);
+        for(std::size_t y = 0; y < height; y++) {
+            data[x + y * width] = column[y];
+        }
+    }
+}
+
+std::pmr::vector<std::uint32_t> correlate(const BitImage &image, const BitView &text, std::uint32_t min_x, std::uint32_t min_y, std::uint32_t max_x, std::uint32_t max_y, std::pmr::memory_resource *resource) {
+    std::uint32_t positions_x = max_x - min_x;
+    std::uint32_t positions_y = max_y - min_y;
+    std::pmr::vector<std::uint32_t> overlap(static_cast<std::size_t>(positions_x) * positions_y, resource);
+
+    // Only the part of the image that the template can cover is transformed
+    if(text.width == 0 || text.height == 0 || min_x >= image.width || min_y >= image.height) {
+        return overlap;
+    }
+    std::uint32_t region_width = std::min(positions_x + text.width - 1, image.width - min_x);
+    std::uint32_t region_height = std::min(positions_y + text.height - 1, image.height - min_y);
+
+    // Being at least as large as the region means the circular correlation never wraps for positions that fit
+    std::size_t fft_width = next_power_of_two(region_width);
+    std::size_t fft_height = next_power_of_two(region_height);
+
+    std::pmr::vector<std::complex<double>> image_frequencies(fft_width * fft_height, resource);
+    for(std::uint32_t y = 0; y < region_height; y++) {
+        for(std::uint32_t x = 0; x < region_width; x++) {
+            image_frequencies[x + y * fft_width] = image.get(x + min_x, y + min_y) ? 1.0 : 0.0;
+        }
+    }
+
+    std::pmr::vector<std::complex<double>> text_frequencies(fft_width * fft_height, resource);
+    for(std::uint32_t y = 0; y < text.height && y < fft_height; y++) {
+        for(std::uint32_t x = 0; x < text.width && x < fft_width; x++) {
+            text_frequencies[x + y * fft_width] = text.get(x, y) ? 1.0 : 0.0;
+        }
+    }
+
+    fft_2d(image_frequencies, fft_width, fft_height, false);
+    fft_2d(text_frequencies, fft_width, fft_height, false);
+    for(std::size_t i = 0; i < image_frequencies.size(); i++) {
+        image_frequencies[i] *= std::conj(text_frequencies[i]);
+    }
+    fft_2d(image_frequencies, fft_width, fft_height, true);
+
+    // Round back to whole pixels; counts are small enough that double precision error is far below 0.5
+    double scale = 1.0 / static_cast<double>(fft_width * fft_height);
+    for(std::uint32_t y = 0; y < positions_y; y++) {
+        for(std::uint32_t x = 0; x < positions_x; x++) {
+            std::uint32_t image_x = x + min_x;
+            std::uint32_t image_y = y + min_y;
+            if(image_x + text.width > image.width || image_y + text.height > image.height) {
+                continue;
+            }
+            overlap[x + y * positions_x] = static_cast<std::uint32_t>(std::lround(image_frequencies[x + y * fft_width].real() * scale));
+        }
+    }
+
+    return overlap;
+}
+
+bool correlation_is_cheaper(const BitView &text, std::uint32_t min_x, std::uint32_t min_y, std::uint32_t max_x, std::uint32_t max_y) {
+    // Allow forcing one or the other for testing
+    static const char *forced = std::getenv("CARNAGE_REPORTER_CORRELATION");
+    if(forced && std::strcmp(forced, "fft") == 0) {
+        return true;
+    }
+    if(forced && std::strcmp(forced, "direct") == 0) {
+        return false;
+    }
+
+    double positions = static_cast<double>(max_x - min_x) * (max_y - min_y);
+    double direct = positions * text.height * ((text.width + 63) / 64);
+
+    double fft_size = static_cast<double>(next_power_of_two(max_x - min_x + text.width)) * next_power_of_two(max_y - min_y + text.height);
+    double fft = 3.0 * fft_size * static_cast<double>(log2_of(static_cast<std::size_t>(fft_size))) / 2.0 * BUTTERFLY_COST;
+
+    return fft < direct;
+}
@@ -0,0 +1,45 @@
+#ifndef CARNAGE_REPORTER__CORRELATION_HPP
+#define CARNAGE_REPORTER__CORRELATION_HPP
+
+#include <complex>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "bit_image.hpp"
+
+/**
+ * Transform a sequence in place with a radix-2 fast Fourier transform
+ * @param data    sequence to transform
+ * @param size    length of the sequence; must be a power of two
+ * @param inverse do the inverse transform (without dividing by the size)
+ */
+void fft(std::complex<double> *data, std::size_t size, bool inverse);
+
+/**
+ * Count how many set pixels of a template land on set pixels of an image for every position in a rectangle, using the
+ * frequency domain so the cost doesn't depend on the size of the template
+ * @param image image to search
+ * @param text  template to search for
+ * @param min_x leftmost position
+ * @param min_y topmost position
+ * @param max_x rightmost position (exclusive)
+ * @param max_y    bottommost position (exclusive)
+ * @param resource where to allocate the result and the transforms
+ * @return         overlapping set pixels, indexed by (x - min_x) + (y - min_y) * (max_x - min_x); positions where the
+ *                 template does not fit in the image are 0
+ */
+std::pmr::vector<std::uint32_t> correlate(const BitImage &image, const BitView &text, std::uint32_t min_x, std::uint32_t min_y, std::uint32_t max_x, std::uint32_t max_y, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+/**
+ * Estimate the cost of correlate() relative to matching every position directly with the packed match kernel
+ * @param text  template to search for
+ * @param min_x leftmost position
+ * @param min_y topmost position
+ * @param max_x rightmost position (exclusive)
+ * @param max_y bottommost position (exclusive)
+ * @return      true if correlating in the frequency domain should be cheaper
+ */
+bool correlation_is_cheaper(const BitView &text, std::uint32_t min_x, std::uint32_t min_y, std::uint32_t max_x, std::uint32_t max_y);
+
+#endif
@@ -0,0 +1,45 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "compiled_font.hpp"
+#include "eprintf.hpp"
+
+/**
+ * Build tool that compiles a font tag into a header, so the font can be built into carnage-reporter
+ */
+int main(int argc, const char **argv) {
+    if(argc != 3) {
+        eprintf("Usage: %s <font> <output.hpp>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto font = CompiledFont::compile(load_font(argv[1]));
+
+    // Write it as 64-bit words so the array is aligned the same way a mapped file would be
+    std::size_t word_count = font.get_size() / sizeof(std::uint64_t);
+    std::FILE *f = std::fopen(argv[2], "wb");
+    if(!f) {
+        eprintf("Failed to open %s for writing\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    std::fprintf(f, "// Generated from %s by %s. Do not edit.\n\n", argv[1], argv[0]);
+    std::fprintf(f, "#ifndef CARNAGE_REPORTER__BUILTIN_FONT_HPP\n#define CARNAGE_REPORTER__BUILTIN_FONT_HPP\n\n#include <cstdint>\n\n");
+    std::fprintf(f, "/** Compiled font file of the built-in font, in the byte order of the machine it was generated on */\n");
+    std::fprintf(f, "alignas(64) static constexpr std::uint64_t BUILTIN_FONT[%zu] = {", word_count);
+    for(std::size_t i = 0; i < word_count; i++) {
+        std::uint64_t word;
+        std::memcpy(&word, font.get_data() + i * sizeof(word), sizeof(word));
+        std::fprintf(f, "%s0x%016" PRIX64 ",", (i % 4) ? " " : "\n    ", word);
+    }
+    std::fprintf(f, "\n};\n\n#endif\n");
+
+    if(std::fclose(f) != 0) {
+        eprintf("Failed to write %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
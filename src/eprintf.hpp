@@ -0,0 +1,8 @@
+#ifndef CARNAGE_REPORTER__EPRINTF_HPP
+#define CARNAGE_REPORTER__EPRINTF_HPP
+
+#include <cstdio>
+
+#define eprintf(...) std::fprintf(stderr, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,64 @@
+#include <cstdarg>
+#include <cstdio>
+#include <new>
+
+#include "error.hpp"
+
+static std::string format_message_list(const char *format, std::va_list arguments) {
+    std::va_list arguments_copy;
+    va_copy(arguments_copy, arguments);
+    int length = std::vsnprintf(nullptr, 0, format, arguments_copy);
+    va_end(arguments_copy);
+
+    std::string message(length > 0 ? static_cast<std::size_t>(length) : 0, '\0');
+    std::vsnprintf(message.data(), message.size() + 1, format, arguments);
+    return message;
+}
+
+const char *get_error_kind_name(ErrorKind kind) {
+    switch(kind) {
+        case ErrorKind::FONT_UNREADABLE:
+            return "font-unreadable";
+        case ErrorKind::DECODE_FAILED:
+            return "decode-failed";
+        case ErrorKind::UNSUPPORTED_SIZE:
+            return "unsupported-size";
+        case ErrorKind::HEADER_NOT_FOUND:
+            return "header-not-found";
+        case ErrorKind::WRITE_FAILED:
+            return "write-failed";
+        case ErrorKind::NAMES_UNREADABLE:
+            return "names-unreadable";
+        case ErrorKind::BAD_REQUEST:
+            return "bad-request";
+        case ErrorKind::ARCHIVE_UNREADABLE:
+            return "archive-unreadable";
+        case ErrorKind::READ_FAILED:
+            return "read-failed";
+    }
+    return "unknown";
+}
+
+CarnageError make_read_error(const std::exception &exception) {
+    if(dynamic_cast<const std::bad_alloc *>(&exception)) {
+        return CarnageError(ErrorKind::READ_FAILED, "Ran out of memory");
+    }
+    return CarnageError(ErrorKind::READ_FAILED, format_message("Unexpected error: %s", exception.what()));
+}
+
+std::string format_message(const char *format, ...) {
+    std::va_list arguments;
+    va_start(arguments, format);
+    auto message = format_message_list(format, arguments);
+    va_end(arguments);
+    return message;
+}
+
+void throw_error(ErrorKind kind, const char *format, ...) {
+    std::va_list arguments;
+    va_start(arguments, format);
+    auto message = format_message_list(format, arguments);
+    va_end(arguments);
+
+    throw CarnageError(kind, message);
+}
@@ -0,0 +1,126 @@
+#ifndef CARNAGE_REPORTER__ERROR_HPP
+#define CARNAGE_REPORTER__ERROR_HPP
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+/**
+ * What went wrong
+ */
+enum class ErrorKind {
+    /** The font tag couldn't be opened */
+    FONT_UNREADABLE,
+
+    /** The screenshot couldn't be opened or decoded */
+    DECODE_FAILED,
+
+    /** The screenshot isn't 480p */
+    UNSUPPORTED_SIZE,
+
+    /** A column header didn't match well enough anywhere it was looked for */
+    HEADER_NOT_FOUND,
+
+    /** The results couldn't be written */
+    WRITE_FAILED,
+
+    /** A names file couldn't be opened */
+    NAMES_UNREADABLE,
+
+    /** A request to read a screenshot didn't make sense */
+    BAD_REQUEST,
+
+    /** An archive of screenshots is truncated or isn't an archive */
+    ARCHIVE_UNREADABLE,
+
+    /** Something else went wrong while reading, such as running out of memory */
+    READ_FAILED
+};
+
+/**
+ * Get a short name for a kind of error, suitable for logs and machine-readable output
+ * @param kind kind of error
+ * @return     name, such as "header-not-found"
+ */
+const char *get_error_kind_name(ErrorKind kind);
+
+/**
+ * The best guess for a column header that wasn't found
+ */
+struct HeaderMiss {
+    /** Text of the header */
+    std::string header;
+
+    /** Best score anywhere it was looked for */
+    float best_score;
+
+    /** Where that score was */
+    std::uint32_t x;
+    std::uint32_t y;
+};
+
+/**
+ * A font tag or screenshot that couldn't be read. Nothing outside of main() exits the program; anything that fails
+ * throws this instead, with a message that is ready to show and enough detail to report it some other way.
+ */
+class CarnageError : public std::runtime_error {
+public:
+    /**
+     * Get what went wrong
+     * @return kind of error
+     */
+    ErrorKind get_kind() const {
+        return this->kind;
+    }
+
+    /**
+     * Get the best guess for the header that wasn't found, if that is what went wrong
+     * @return best guess, or std::nullopt
+     */
+    const std::optional<HeaderMiss> &get_header_miss() const {
+        return this->header_miss;
+    }
+
+    /**
+     * Create an error
+     * @param kind        what went wrong
+     * @param message     message to show
+     * @param header_miss best guess for the header that wasn't found, for HEADER_NOT_FOUND
+     */
+    CarnageError(ErrorKind kind, const std::string &message, std::optional<HeaderMiss> header_miss = std::nullopt) : std::runtime_error(message), kind(kind), header_miss(std::move(header_miss)) {}
+
+private:
+    ErrorKind kind;
+    std::optional<HeaderMiss> header_miss;
+};
+
+/**
+ * Make a CarnageError out of any other exception, such as std::bad_alloc, so a screenshot that fails some unexpected way
+ * can be reported like any other and the rest can still be read
+ * @param exception exception that was caught
+ * @return          READ_FAILED error
+ */
+CarnageError make_read_error(const std::exception &exception);
+
+/**
+ * Format a printf-style message
+ * @param format format string
+ * @return       message
+ */
+#ifdef __GNUC__
+__attribute__((format(printf, 1, 2)))
+#endif
+std::string format_message(const char *format, ...);
+
+/**
+ * Throw a CarnageError with a printf-style message
+ * @param kind   what went wrong
+ * @param format format string
+ */
+#ifdef __GNUC__
+__attribute__((format(printf, 2, 3)))
+#endif
+[[noreturn]] void throw_error(ErrorKind kind, const char *format, ...);
+
+#endif
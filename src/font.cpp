@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "font.hpp"
+#include "hash.hpp"
+#include "error.hpp"
+
+std::vector<std::byte> read_font_file(const char *path) {
+    // Load the font tag
+    std::FILE *f = std::fopen(path, "rb");
+    if(!f) {
+        throw_error(ErrorKind::FONT_UNREADABLE, "Could not open font tag %s", path);
+    }
+
+    // Read the whole thing so it can be hashed, too
+    std::vector<std::byte> data;
+    std::byte buffer[4096];
+    std::size_t read;
+    while((read = std::fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    std::fclose(f);
+
+    return data;
+}
+
+FontTag parse_font(const std::vector<std::byte> &data) {
+    FontTag tag;
+    tag.source_hash = hash_bytes(data.data(), data.size());
+
+    // Copy the next bytes out of the tag, zeroing anything past the end of it
+    std::size_t cursor = 0;
+    auto read_bytes = [&data, &cursor](void *output, std::size_t size) {
+        std::size_t available = cursor < data.size() ? std::min(size, data.size() - cursor) : 0;
+        std::memcpy(output, data.data() + cursor, available);
+        std::memset(reinterpret_cast<std::byte *>(output) + available, 0, size - available);
+        cursor += size;
+    };
+
+    // First, seek to the font tag header
+    cursor = 0x40;
+
+    // Read the data
+    auto &font = tag.font;
+    read_bytes(&font, sizeof(font));
+
+    // Skip that shit
+    auto character_tables_count = swap_endian(font.character_tables.count);
+    if(character_tables_count) {
+        std::vector<TagReflexive> tables(character_tables_count);
+        read_bytes(tables.data(), character_tables_count * 0xC);
+
+        for(auto &table : tables) {
+            cursor += 2 * swap_endian(table.count);
+        }
+    }
+
+    // Read characters
+    auto &characters = tag.characters;
+    characters.resize(256);
+    auto character_count = swap_endian(font.characters.count);
+
+    std::vector<FontCharacter> all_characters(character_count);
+    read_bytes(all_characters.data(), character_count * sizeof(FontCharacter));
+
+    for(auto &c : all_characters) {
+        auto character_index = swap_endian(c.character);
+        if(character_index < 256 && character_index > 0) {
+            characters[character_index] = c;
+        }
+    }
+
+    // Lastly, finish the thing
+    std::uint32_t pixel_size = swap_endian(font.pixels.count);
+    tag.pixels.resize(pixel_size);
+    read_bytes(tag.pixels.data(), pixel_size);
+
+    return tag;
+}
+
+FontTag load_font(const char *path) {
+    return parse_font(read_font_file(path));
+}
+
+MonochromeImage draw_text(const char *text, const FontTag &font_tag) {
+    const auto &font = font_tag.font;
+    const auto &characters = font_tag.characters;
+    const auto &monochrome_pixels = font_tag.pixels;
+
+    std::vector<FontCharacter> characters_to_draw;
+    for(const char *c = text; *c; c++) {
+        characters_to_draw.push_back(characters[static_cast<std::uint8_t>(*c)]);
+    }
+
+    // Get ready to draw some pixels
+    MonochromeImage drawn_text = {};
+    drawn_text.text = text;
+    drawn_text.height = swap_endian(font.ascending_height) + swap_endian(font.descending_height);
+    for(auto &c : characters_to_draw) {
+        drawn_text.width += swap_endian(c.character_width);
+    }
+    drawn_text.pixels.insert(drawn_text.pixels.begin(), drawn_text.height * drawn_text.width, Monochrome());
+
+    std::uint32_t x_cursor = 0;
+
+    // Draw those pixels
+    for(auto &c : characters_to_draw) {
+        auto bitmap_width = swap_endian(c.bitmap_width);
+        auto bitmap_height = swap_endian(c.bitmap_height);
+
+        auto bitmap_y = swap_endian(font.ascending_height) - swap_endian(c.bitmap_origin_y);
+
+        if(bitmap_width > 0 && bitmap_height > 0) {
+            auto *pixels = monochrome_pixels.data() + swap_endian(c.pixels_offset);
+
+            auto set_pixel = [&drawn_text](std::uint32_t x, std::uint32_t y, const Monochrome &pixel) {
+                if(drawn_text.width > x && drawn_text.height > y) {
+                    auto &output_pixel = drawn_text.pixels[x + y * drawn_text.width];
+                    output_pixel = static_cast<std::uint8_t>(static_cast<std::uint32_t>(pixel.intensity) * 3 / 4);
+                }
+            };
+
+            for(std::uint32_t y = 0; y < static_cast<std::uint32_t>(bitmap_height); y++) {
+                for(std::uint32_t x = 0; x < static_cast<std::uint32_t>(bitmap_width); x++) {
+                    set_pixel(x_cursor + x, y + bitmap_y, pixels[x + y * bitmap_width]);
+                }
+            }
+        }
+        x_cursor += swap_endian(c.character_width);
+    }
+
+    return drawn_text;
+}
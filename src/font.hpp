@@ -0,0 +1,100 @@
+#ifndef CARNAGE_REPORTER__FONT_HPP
+#define CARNAGE_REPORTER__FONT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "image.hpp"
+
+struct TagReflexive {
+    std::uint32_t count;
+    std::uint32_t reserved[2];
+};
+
+struct TagDataOffset {
+    std::uint32_t count;
+    std::uint32_t reserved[4];
+};
+
+template<typename T> inline T swap_endian(const T &value) {
+    std::byte c[sizeof(T)];
+    const std::byte *cr = reinterpret_cast<const std::byte *>(&value);
+    for(std::size_t i = 0; i < sizeof(T); i++) {
+        c[i] = cr[sizeof(T) - 1 - i];
+    }
+    return *reinterpret_cast<T *>(c);
+}
+
+struct Font {
+    std::int32_t flags;
+    std::int16_t ascending_height;
+    std::int16_t descending_height;
+    std::int16_t leading_height;
+    std::int16_t leading_width;
+    char padding[0x24];
+    TagReflexive character_tables;
+    char bold[0x10]; // font
+    char italic[0x10]; // font
+    char condense[0x10]; // font
+    char underline[0x10]; // font
+    TagReflexive characters;
+    TagDataOffset pixels;
+};
+static_assert(sizeof(Font) == 0x9C);
+
+struct FontCharacter {
+    std::int16_t character;
+    std::int16_t character_width;
+    std::int16_t bitmap_width;
+    std::int16_t bitmap_height;
+    std::int16_t bitmap_origin_x;
+    std::int16_t bitmap_origin_y;
+    std::int16_t hardware_character_index;
+    char padding[0x2];
+    std::uint32_t pixels_offset;
+};
+static_assert(sizeof(FontCharacter) == 0x14);
+
+/**
+ * A font tag that has been read from disk. All fields are still big endian.
+ */
+struct FontTag {
+    Font font;
+    std::vector<FontCharacter> characters;
+    std::vector<Monochrome> pixels;
+
+    /** Hash of the whole tag file, for telling whether a cache was built from this tag */
+    std::uint64_t source_hash;
+};
+
+/**
+ * Read a font tag file, throwing a CarnageError if it could not be opened
+ * @param path path to the font tag
+ * @return     contents of the file
+ */
+std::vector<std::byte> read_font_file(const char *path);
+
+/**
+ * Parse a font tag
+ * @param data contents of the font tag file
+ * @return     font tag
+ */
+FontTag parse_font(const std::vector<std::byte> &data);
+
+/**
+ * Load a font tag, throwing a CarnageError if it could not be opened
+ * @param path path to the font tag
+ * @return     font tag
+ */
+FontTag load_font(const char *path);
+
+/**
+ * Render text with a font
+ * @param text text to render
+ * @param font font to render with
+ * @return     rendered text
+ */
+MonochromeImage draw_text(const char *text, const FontTag &font);
+
+#endif
@@ -0,0 +1,42 @@
+#include "glyph_trie.hpp"
+
+GlyphTrie::GlyphTrie(const std::vector<BitView> &names, const std::vector<BitView> &glyphs) : nodes(1) {
+    const BitView *glyph_of[256] = {};
+    for(auto &glyph : glyphs) {
+        glyph_of[static_cast<std::uint8_t>(glyph.text[0])] = &glyph;
+    }
+
+    for(auto &name : names) {
+        std::uint32_t node = ROOT;
+        for(char c : name.text) {
+            const auto *glyph = glyph_of[static_cast<std::uint8_t>(c)];
+            if(!glyph) {
+                break;
+            }
+
+            auto child = this->get_child(node, c);
+            if(!child.has_value()) {
+                child = static_cast<std::uint32_t>(this->nodes.size());
+                this->nodes[node].children.push_back(Child { c, *child, glyph });
+                this->nodes.emplace_back();
+            }
+            node = *child;
+        }
+    }
+}
+
+void GlyphTrie::get_glyphs(std::uint32_t node, std::pmr::vector<const BitView *> &glyphs) const {
+    glyphs.clear();
+    for(auto &child : this->nodes[node].children) {
+        glyphs.push_back(child.glyph);
+    }
+}
+
+std::optional<std::uint32_t> GlyphTrie::get_child(std::uint32_t node, char character) const {
+    for(auto &child : this->nodes[node].children) {
+        if(child.character == character) {
+            return child.node;
+        }
+    }
+    return std::nullopt;
+}
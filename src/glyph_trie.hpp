@@ -0,0 +1,65 @@
+#ifndef CARNAGE_REPORTER__GLYPH_TRIE_HPP
+#define CARNAGE_REPORTER__GLYPH_TRIE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+#include "bit_image.hpp"
+
+/**
+ * A trie of the names in a roster, spelled with the glyphs of a font. Reading a name one glyph at a time, the node for
+ * what has been read so far gives the only glyphs that can come next if the name is on the roster.
+ */
+class GlyphTrie {
+public:
+    /** Node for an empty prefix */
+    static constexpr std::uint32_t ROOT = 0;
+
+    /**
+     * Get the glyphs that extend a prefix into a prefix of some name
+     * @param node   node of the prefix
+     * @param glyphs cleared, then set to the glyphs
+     */
+    void get_glyphs(std::uint32_t node, std::pmr::vector<const BitView *> &glyphs) const;
+
+    /**
+     * Extend a prefix by a character
+     * @param node      node of the prefix
+     * @param character character to add
+     * @return          node of the longer prefix, or std::nullopt if no name starts with it
+     */
+    std::optional<std::uint32_t> get_child(std::uint32_t node, char character) const;
+
+    /**
+     * Get whether or not any name is in the trie
+     * @return true if empty
+     */
+    bool empty() const {
+        return this->nodes[ROOT].children.empty();
+    }
+
+    /**
+     * Build a trie
+     * @param names  names to add
+     * @param glyphs glyph table to spell them with; characters not in it can't be read, so names stop before them
+     */
+    GlyphTrie(const std::vector<BitView> &names, const std::vector<BitView> &glyphs);
+
+private:
+    struct Child {
+        char character;
+        std::uint32_t node;
+        const BitView *glyph;
+    };
+
+    struct Node {
+        std::vector<Child> children;
+    };
+
+    std::vector<Node> nodes;
+};
+
+#endif
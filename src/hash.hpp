@@ -0,0 +1,25 @@
+#ifndef CARNAGE_REPORTER__HASH_HPP
+#define CARNAGE_REPORTER__HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Hash bytes with 64-bit FNV-1a. This is used to tell whether a cache file was built from the same input, not for
+ * anything security related.
+ * @param data  bytes to hash
+ * @param size  number of bytes
+ * @param basis hash to continue from, if hashing several buffers as one
+ * @return      hash
+ */
+inline std::uint64_t hash_bytes(const void *data, std::size_t size, std::uint64_t basis = 0xCBF29CE484222325) {
+    const auto *bytes = reinterpret_cast<const std::uint8_t *>(data);
+    std::uint64_t hash = basis;
+    for(std::size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3;
+    }
+    return hash;
+}
+
+#endif
@@ -0,0 +1,12 @@
+#include "image.hpp"
+
+void filter_monochrome(std::vector<Monochrome> &monochrome_data) {
+    for(auto &m : monochrome_data) {
+        if(m < MONOCHROME_THRESHOLD) {
+            m = 0;
+        }
+        else {
+            m = 0xFF;
+        }
+    }
+}
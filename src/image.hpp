@@ -0,0 +1,70 @@
+#ifndef CARNAGE_REPORTER__IMAGE_HPP
+#define CARNAGE_REPORTER__IMAGE_HPP
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+/**
+ * A single color, holding values for four channels: red, green, blue, and alpha
+ */
+struct ImagePixel {
+    std::uint8_t red;
+    std::uint8_t green;
+    std::uint8_t blue;
+    std::uint8_t alpha;
+};
+
+struct Monochrome {
+    std::uint8_t intensity;
+
+    Monochrome() = default;
+    Monochrome(const Monochrome &) = default;
+    Monochrome(const ImagePixel &pixel) {
+        // Based on Luma
+        static const std::uint8_t RED_WEIGHT = 0x90;
+        static const std::uint8_t GREEN_WEIGHT = 0x0F;
+        static const std::uint8_t BLUE_WEIGHT = 0x60;
+        static_assert(RED_WEIGHT + GREEN_WEIGHT + BLUE_WEIGHT == UINT8_MAX, "red + green + blue weights (grayscale) must equal 255");
+
+        this->intensity = 0;
+        #define COMPOSITE_BITMAP_GRAYSCALE_SET_CHANNEL_VALUE_FOR_COLOR(channel, weight) \
+            this->intensity += (pixel.channel * weight + (UINT8_MAX + 1) / 2) / UINT8_MAX;
+
+        COMPOSITE_BITMAP_GRAYSCALE_SET_CHANNEL_VALUE_FOR_COLOR(red, RED_WEIGHT)
+        COMPOSITE_BITMAP_GRAYSCALE_SET_CHANNEL_VALUE_FOR_COLOR(green, GREEN_WEIGHT)
+        COMPOSITE_BITMAP_GRAYSCALE_SET_CHANNEL_VALUE_FOR_COLOR(blue, BLUE_WEIGHT)
+
+        #undef COMPOSITE_BITMAP_GRAYSCALE_SET_CHANNEL_VALUE_FOR_COLOR
+    }
+
+    operator std::uint8_t &() {
+        return this->intensity;
+    }
+
+    void operator=(const std::uint8_t &new_intensity) {
+        this->intensity = new_intensity;
+    }
+};
+
+template<typename T> struct Image {
+    std::uint32_t width;
+    std::uint32_t height;
+    std::vector<T> pixels;
+    std::string text;
+};
+
+using MonochromeImage = Image<Monochrome>;
+
+/**
+ * Monochrome pixels at or above this intensity are treated as set; everything else is background
+ */
+static constexpr std::uint8_t MONOCHROME_THRESHOLD = 0x4F;
+
+/**
+ * Threshold monochrome pixels to either 0x00 or 0xFF
+ * @param monochrome_data pixels to threshold
+ */
+void filter_monochrome(std::vector<Monochrome> &monochrome_data);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef CARNAGE_REPORTER__JOB_QUEUE_HPP
+#define CARNAGE_REPORTER__JOB_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+/**
+ * Jobs waiting for any of a number of worker threads, handed out in the order they were pushed
+ */
+template<typename Job> class JobQueue {
+public:
+    /**
+     * Add a job and wake a worker for it
+     * @param job job to add
+     */
+    void push(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->jobs.push_back(std::move(job));
+        }
+        this->ready.notify_one();
+    }
+
+    /**
+     * Stop waiting for more jobs once the queue runs dry
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->closed = true;
+        }
+        this->ready.notify_all();
+    }
+
+    /**
+     * Wait for the next job
+     * @return job, or std::nullopt if the queue is closed and empty
+     */
+    std::optional<Job> pop() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->ready.wait(lock, [this]() {
+            return this->closed || !this->jobs.empty();
+        });
+        if(this->jobs.empty()) {
+            return std::nullopt;
+        }
+        auto job = std::move(this->jobs.front());
+        this->jobs.pop_front();
+        return job;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Job> jobs;
+    bool closed = false;
+};
+
+#endif
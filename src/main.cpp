@@ -1,646 +1,914 @@
+#include <cinttypes>
 #include <cstdint>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
-#include <vector>
 #include <cstring>
-#include <string>
-#include <optional>
+#include <cctype>
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
 #include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include "stb/stb_image.h"
+#include "recognizer.hpp"
+#include "hash.hpp"
+#include "allocation_counter.hpp"
+#include "work_pool.hpp"
+#include "job_queue.hpp"
+#include "tar_reader.hpp"
+#include "read_ahead.hpp"
+#include "pipeline.hpp"
+#include "serve.hpp"
+#include "eprintf.hpp"
+
+#ifdef CARNAGE_REPORTER_SOCKET_SERVICE
+#include "socket_service.hpp"
+#endif
+
+#ifdef CARNAGE_REPORTER_BUILTIN_FONT
+#include "builtin_font.hpp"
+#endif
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+static void print_usage(const char *program) {
+    eprintf("Usage: %s <image> <font> <output.csv> [names.txt ...]\n", program);
+    eprintf("       %s --batch [--jobs N] [--read-ahead N] [--merge] <directory|list.txt> <font> <output> [names.txt ...]\n", program);
+    eprintf("       %s --batch --pipeline D,B,R [--merge] <directory|list.txt> <font> <output> [names.txt ...]\n", program);
+    eprintf("       %s --batch --tar [--jobs N] [--merge] <archive.tar> <font> <output> [names.txt ...]\n", program);
+    eprintf("       %s --serve [--jobs N] <font> [names.txt ...]\n", program);
+    #ifdef CARNAGE_REPORTER_SOCKET_SERVICE
+    eprintf("       %s --listen <socket> [--jobs N] [--queue-depth N] <font> [names.txt ...]\n", program);
+    #endif
+    #ifdef CARNAGE_REPORTER_BUILTIN_FONT
+    eprintf("       %s --builtin-font [--batch ...] <image|directory|list.txt> <output> [names.txt ...]\n", program);
+    eprintf("       %s --builtin-font --serve [--jobs N] [names.txt ...]\n", program);
+    #endif
+    eprintf("\n");
+    eprintf("An <image>, <list.txt>, or <archive.tar> of - is read from standard input.\n");
+    eprintf("\n");
+    eprintf("Options:\n");
+    eprintf("  --batch      Read every image in a directory, or every image path listed in a text file (one per line).\n");
+    eprintf("               Unless --merge is used, <output> is a directory that gets one CSV per image.\n");
+    eprintf("  --serve      Read requests from standard input until it is closed, one per line: <image>, <output.csv>,\n");
+    eprintf("               and optionally a names file to use instead of [names.txt ...], separated by tabs. One line\n");
+    eprintf("               of JSON is written to standard output for each request as soon as it finishes.\n");
+    #ifdef CARNAGE_REPORTER_SOCKET_SERVICE
+    eprintf("  --listen <socket>\n");
+    eprintf("               Read images sent to a Unix domain socket at this path until interrupted, replying to each\n");
+    eprintf("               with its CSV. carnage-reporter-client and carnage-reporter-loadgen send images to it.\n");
+    eprintf("  --queue-depth N\n");
+    eprintf("               Most images the socket service holds at once before it stops taking more. Defaults to four\n");
+    eprintf("               per job.\n");
+    #endif
+    eprintf("  --jobs N     Number of images to read at once in batch, serve, or socket mode. Defaults to the number of\n");
+    eprintf("               hardware threads.\n");
+    eprintf("  --merge      Write a single CSV to <output> with the image as the first column, in input order.\n");
+    eprintf("  --pipeline D,B,R\n");
+    eprintf("               In batch mode, decode images on D threads, reduce them to bit planes on B threads, and read\n");
+    eprintf("               them on R threads, and report how busy each stage was. Replaces --jobs.\n");
+    eprintf("  --read-ahead N\n");
+    eprintf("               Keep up to N image files being read into memory ahead of the jobs in batch mode, using\n");
+    eprintf("               io_uring where available, and report how long the jobs waited for them.\n");
+    eprintf("  --tar        Read every image in an uncompressed tar archive in batch mode as it streams in, without\n");
+    eprintf("               unpacking it. Images are named by their paths in the archive.\n");
+    eprintf("  --stats      Print how many pixel comparisons template matching did and avoided, and how many heap\n");
+    eprintf("               allocations reading each image took.\n");
+    eprintf("  --font-cache <path>\n");
+    eprintf("               Map the compiled font from this file, compiling and writing it first if it is missing or was\n");
+    eprintf("               compiled from a different font tag.\n");
+    eprintf("  --roster-decoding\n");
+    eprintf("               Read names that don't match the names files well enough by following those names glyph by\n");
+    eprintf("               glyph for as long as one of them fits, then trying every glyph for the rest.\n");
+    eprintf("  --dp-decoding\n");
+    eprintf("               Read text by finding the sequence of glyphs that matches best overall instead of the best\n");
+    eprintf("               glyph at each step.\n");
+    eprintf("  --roster-cache <path>\n");
+    eprintf("               Map the rendered names from this file, rendering only names that are new to it and rewriting\n");
+    eprintf("               it whenever the names or the font tag change.\n");
+    #ifdef CARNAGE_REPORTER_BUILTIN_FONT
+    eprintf("  --builtin-font\n");
+    eprintf("               Use the font built into this program. No <font> argument is given.\n");
+    #endif
+}
 
-#define eprintf(...) std::fprintf(stderr, __VA_ARGS__)
+static void print_match_statistics(const MatchStatistics &statistics) {
+    std::uint64_t pixels = statistics.pixels_compared + statistics.pixels_skipped;
+    eprintf("Matched %llu windows; %llu stopped early\n", static_cast<unsigned long long>(statistics.matches), static_cast<unsigned long long>(statistics.early_exits));
+    eprintf("Compared %llu pixels; avoided %llu pixel comparisons (%.1f%%)\n", static_cast<unsigned long long>(statistics.pixels_compared), static_cast<unsigned long long>(statistics.pixels_skipped), pixels ? 100.0 * statistics.pixels_skipped / pixels : 0.0);
+}
 
 /**
- * A single color, holding values for four channels: red, green, blue, and alpha
+ * Heap allocations made while reading images. A thread's first image is counted separately, since that is when its
+ * arena grows to fit.
  */
-struct ImagePixel {
-    std::uint8_t red;
-    std::uint8_t green;
-    std::uint8_t blue;
-    std::uint8_t alpha;
-};
-
-struct Monochrome {
-    std::uint8_t intensity;
-
-    Monochrome() = default;
-    Monochrome(const Monochrome &) = default;
-    Monochrome(const ImagePixel &pixel) {
-        // Based on Luma
-        static const std::uint8_t RED_WEIGHT = 0x90;
-        static const std::uint8_t GREEN_WEIGHT = 0x0F;
-        static const std::uint8_t BLUE_WEIGHT = 0x60;
-        static_assert(RED_WEIGHT + GREEN_WEIGHT + BLUE_WEIGHT == UINT8_MAX, "red + green + blue weights (grayscale) must equal 255");
-
-        this->intensity = 0;
-        #define COMPOSITE_BITMAP_GRAYSCALE_SET_CHANNEL_VALUE_FOR_COLOR(channel, weight) \
-            this->intensity += (pixel.channel * weight + (UINT8_MAX + 1) / 2) / UINT8_MAX;
-
-        COMPOSITE_BITMAP_GRAYSCALE_SET_CHANNEL_VALUE_FOR_COLOR(red, RED_WEIGHT)
-        COMPOSITE_BITMAP_GRAYSCALE_SET_CHANNEL_VALUE_FOR_COLOR(green, GREEN_WEIGHT)
-        COMPOSITE_BITMAP_GRAYSCALE_SET_CHANNEL_VALUE_FOR_COLOR(blue, BLUE_WEIGHT)
-
-        #undef COMPOSITE_BITMAP_GRAYSCALE_SET_CHANNEL_VALUE_FOR_COLOR
-    }
-
-    operator std::uint8_t &() {
-        return this->intensity;
-    }
-
-    void operator=(const std::uint8_t &new_intensity) {
-        this->intensity = new_intensity;
+struct AllocationStatistics {
+    std::uint64_t first_images = 0;
+    std::uint64_t first_image_allocations = 0;
+    std::uint64_t images = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t most_allocations = 0;
+
+    void add(const AllocationStatistics &other) {
+        this->first_images += other.first_images;
+        this->first_image_allocations += other.first_image_allocations;
+        this->images += other.images;
+        this->allocations += other.allocations;
+        this->most_allocations = std::max(this->most_allocations, other.most_allocations);
     }
 };
 
-static std::vector<ImagePixel> load_image(const char *path, std::uint32_t &image_width, std::uint32_t &image_height) {
-    // Load it
-    int x = 0, y = 0, channels = 0;
-    auto *image_buffer = reinterpret_cast<ImagePixel *>(stbi_load(path, &x, &y, &channels, 4));
-    if(!image_buffer) {
-        eprintf("Failed to load %s. Error was: %s\n", path, stbi_failure_reason());
-        exit(EXIT_FAILURE);
+static void print_allocation_statistics(const AllocationStatistics &statistics) {
+    if(statistics.first_images) {
+        eprintf("Heap allocations per image: %.1f on each thread's first image", static_cast<double>(statistics.first_image_allocations) / statistics.first_images);
     }
-
-    // Get the width and height
-    image_width = static_cast<std::uint32_t>(x);
-    image_height = static_cast<std::uint32_t>(y);
-    std::vector<ImagePixel> return_value(image_buffer, image_buffer + image_width * image_height);
-
-    // Free the buffer
-    stbi_image_free(image_buffer);
-
-    return return_value;
+    if(statistics.images) {
+        eprintf(", %.1f after that (at most %llu)", static_cast<double>(statistics.allocations) / statistics.images, static_cast<unsigned long long>(statistics.most_allocations));
+    }
+    eprintf("\n");
 }
 
-struct TagReflexive {
-    std::uint32_t count;
-    std::uint32_t reserved[2];
-};
-
-struct TagDataOffset {
-    std::uint32_t count;
-    std::uint32_t reserved[4];
-};
+/**
+ * Stop standard input from translating line endings, since it's about to be used for binary data
+ */
+static void set_binary_standard_input() {
+    #ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    #endif
+}
 
-template<typename T> inline T swap_endian(const T &value) {
-    std::byte c[sizeof(T)];
-    const std::byte *cr = reinterpret_cast<const std::byte *>(&value);
-    for(std::size_t i = 0; i < sizeof(T); i++) {
-        c[i] = cr[sizeof(T) - 1 - i];
+/**
+ * Read all of standard input
+ * @param data set to what was read
+ * @return     true if it was read to the end
+ */
+static bool read_standard_input(std::vector<std::byte> &data) {
+    set_binary_standard_input();
+
+    data.clear();
+    std::byte buffer[65536];
+    std::size_t read;
+    while((read = std::fread(buffer, 1, sizeof(buffer), stdin)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
     }
-    return *reinterpret_cast<T *>(c);
+    return !std::ferror(stdin);
 }
 
-struct Font {
-    std::int32_t flags;
-    std::int16_t ascending_height;
-    std::int16_t descending_height;
-    std::int16_t leading_height;
-    std::int16_t leading_width;
-    char padding[0x24];
-    TagReflexive character_tables;
-    char bold[0x10]; // font
-    char italic[0x10]; // font
-    char condense[0x10]; // font
-    char underline[0x10]; // font
-    TagReflexive characters;
-    TagDataOffset pixels;
-};
-static_assert(sizeof(Font) == 0x9C);
-
-struct FontCharacter {
-    std::int16_t character;
-    std::int16_t character_width;
-    std::int16_t bitmap_width;
-    std::int16_t bitmap_height;
-    std::int16_t bitmap_origin_x;
-    std::int16_t bitmap_origin_y;
-    std::int16_t hardware_character_index;
-    char padding[0x2];
-    std::uint32_t pixels_offset;
-};
-static_assert(sizeof(FontCharacter) == 0x14);
-
-template<typename T> struct Image {
-    std::uint32_t width;
-    std::uint32_t height;
-    std::vector<T> pixels;
-    std::string text;
+/**
+ * An image that couldn't be read or whose results couldn't be written
+ */
+struct ImageFailure {
+    std::size_t image;
+    CarnageError error;
 };
 
-using MonochromeImage = Image<Monochrome>;
-
-MonochromeImage draw_text(const char *text, const std::vector<Monochrome> &monochrome_pixels, const std::vector<FontCharacter> &characters, const Font &font) {
-    std::vector<FontCharacter> characters_to_draw;
-    for(const char *c = text; *c; c++) {
-        characters_to_draw.push_back(characters[static_cast<std::uint8_t>(*c)]);
+/**
+ * What a thread keeps from one image to the next
+ */
+struct Reader {
+    ScratchArena arena;
+    std::vector<PlayerStats> players;
+    AllocationStatistics allocations;
+
+    /** Image read from standard input */
+    std::vector<std::byte> input;
+
+    /** Images this thread failed on */
+    std::vector<ImageFailure> failures;
+
+    /**
+     * Read an image into players, counting the heap allocations it took
+     * @param recognizer recognizer
+     * @param path       path to the image, or - for standard input
+     * @param image      index of the image, for reporting failures
+     * @return           true if the image was read; if not, the failure is recorded and players is left as it was
+     */
+    bool read(const Recognizer &recognizer, const char *path, std::size_t image = 0) {
+        return this->count_allocations(image, [&]() {
+            if(std::strcmp(path, "-") == 0) {
+                if(!read_standard_input(this->input)) {
+                    throw_error(ErrorKind::DECODE_FAILED, "Failed to read an image from standard input");
+                }
+                recognizer.recognize(this->input.data(), this->input.size(), this->arena, this->players);
+            }
+            else {
+                recognizer.recognize(path, this->arena, this->players);
+            }
+        });
     }
 
-    // Get ready to draw some pixels
-    MonochromeImage drawn_text = {};
-    drawn_text.text = text;
-    drawn_text.height = swap_endian(font.ascending_height) + swap_endian(font.descending_height);
-    for(auto &c : characters_to_draw) {
-        drawn_text.width += swap_endian(c.character_width);
+    /**
+     * Read an image file that is already in memory into players, counting the heap allocations it took
+     * @param recognizer recognizer
+     * @param data       contents of the image file
+     * @param size       size of the image file in bytes
+     * @param image      index of the image, for reporting failures
+     * @return           true if the image was read; if not, the failure is recorded and players is left as it was
+     */
+    bool read(const Recognizer &recognizer, const std::byte *data, std::size_t size, std::size_t image) {
+        return this->count_allocations(image, [&]() {
+            recognizer.recognize(data, size, this->arena, this->players);
+        });
     }
-    drawn_text.pixels.insert(drawn_text.pixels.begin(), drawn_text.height * drawn_text.width, Monochrome());
-
-    std::uint32_t x_cursor = 0;
-
-    // Draw those pixels
-    for(auto &c : characters_to_draw) {
-        auto bitmap_width = swap_endian(c.bitmap_width);
-        auto bitmap_height = swap_endian(c.bitmap_height);
-
-        auto bitmap_y = swap_endian(font.ascending_height) - swap_endian(c.bitmap_origin_y);
-
-        if(bitmap_width > 0 && bitmap_height > 0) {
-            auto *pixels = monochrome_pixels.data() + swap_endian(c.pixels_offset);
-
-            auto set_pixel = [&drawn_text](std::uint32_t x, std::uint32_t y, const Monochrome &pixel) {
-                if(drawn_text.width > x && drawn_text.height > y) {
-                    auto &output_pixel = drawn_text.pixels[x + y * drawn_text.width];
-                    output_pixel = static_cast<std::uint8_t>(static_cast<std::uint32_t>(pixel.intensity) * 3 / 4);
-                }
-            };
 
-            for(std::uint32_t y = 0; y < bitmap_height; y++) {
-                for(std::uint32_t x = 0; x < bitmap_width; x++) {
-                    set_pixel(x_cursor + x, y + bitmap_y, pixels[x + y * bitmap_width]);
-                }
-            }
-        }
-        x_cursor += swap_endian(c.character_width);
+    /**
+     * Read an image that has already been reduced to a screenshot into players, counting the heap allocations it took
+     * @param recognizer recognizer
+     * @param screenshot screenshot
+     * @param image      index of the image, for reporting failures
+     * @return           true if the image was read; if not, the failure is recorded and players is left as it was
+     */
+    bool read(const Recognizer &recognizer, const Screenshot &screenshot, std::size_t image) {
+        return this->count_allocations(image, [&]() {
+            recognizer.recognize(screenshot, this->arena, this->players);
+        });
     }
 
-    return drawn_text;
-}
+private:
+    template<typename Read> bool count_allocations(std::size_t image, const Read &read) {
+        auto before = get_thread_allocation_count();
+        try {
+            read();
+        }
+        catch(CarnageError &e) {
+            this->failures.push_back(ImageFailure { image, e });
+            return false;
+        }
+        catch(std::exception &e) {
+            this->failures.push_back(ImageFailure { image, make_read_error(e) });
+            return false;
+        }
+        auto count = get_thread_allocation_count() - before;
 
-void filter_monochrome(std::vector<Monochrome> &monochrome_data) {
-    for(auto &m : monochrome_data) {
-        static constexpr std::uint8_t MINIMUM = 0x4F;
-        if(m < MINIMUM) {
-            m = 0;
+        auto &allocations = this->allocations;
+        if(allocations.first_images == 0) {
+            allocations.first_images = 1;
+            allocations.first_image_allocations = count;
         }
         else {
-            m = 0xFF;
+            allocations.images++;
+            allocations.allocations += count;
+            allocations.most_allocations = std::max(allocations.most_allocations, count);
         }
+        return true;
     }
-}
+};
 
-int main(int argc, const char **argv) {
-    if(argc < 4) {
-        eprintf("Usage: %s <image> <font> <output.csv> [names.txt]\n", argv[0]);
-        return EXIT_FAILURE;
+static bool is_image_extension(std::string extension) {
+    for(auto &c : extension) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
     }
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" || extension == ".tga";
+}
 
-    std::uint32_t width, height;
-    auto image_data = load_image(argv[1], width, height);
-
-    if(height != 480) {
-        eprintf("Cannot support non-480p images right now...\n");
-        return EXIT_FAILURE;
+/**
+ * Say how many images of a batch were read, and list every one that failed and why, in input order
+ * @param readers     readers used for the batch, whose allocations are added to allocations
+ * @param image_names name of each image in the batch
+ * @param allocations statistics to add to
+ * @param failures    failures that happened outside of the readers
+ * @return            exit status
+ */
+static int report_failures(std::vector<Reader> &readers, const std::vector<std::string> &image_names, AllocationStatistics &allocations, std::vector<ImageFailure> failures = {}) {
+    // One bad image doesn't stop the rest
+    for(auto &reader : readers) {
+        allocations.add(reader.allocations);
+        failures.insert(failures.end(), reader.failures.begin(), reader.failures.end());
     }
+    std::sort(failures.begin(), failures.end(), [](const ImageFailure &a, const ImageFailure &b) {
+        return a.image < b.image;
+    });
 
-    // Convert to monochrome
-    std::vector<Monochrome> monochrome_version(image_data.begin(), image_data.end());
-    filter_monochrome(monochrome_version);
-
-    // Load the font tag
-    std::FILE *f = std::fopen(argv[2], "rb");
-    if(!f) {
-        eprintf("Could not open font tag %s\n", argv[2]);
-        return EXIT_FAILURE;
+    eprintf("Read %zu of %zu images\n", image_names.size() - failures.size(), image_names.size());
+    for(auto &failure : failures) {
+        eprintf("  %s: %s: %s\n", image_names[failure.image].data(), get_error_kind_name(failure.error.get_kind()), failure.error.what());
     }
 
-    // First, seek to the font tag header
-    std::fseek(f, 0x40, SEEK_SET);
-
-    // Read the data
-    Font font;
-    std::fread(&font, sizeof(font), 1, f);
+    return failures.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
 
-    // Skip that shit
-    auto character_tables_count = swap_endian(font.character_tables.count);
-    if(character_tables_count) {
-        std::vector<TagReflexive> tables(character_tables_count);
-        std::fread(tables.data(), character_tables_count * 0xC, 1, f);
+static int run_batch(const Recognizer &recognizer, const char *input, const char *output, std::size_t jobs, std::size_t read_ahead_depth, const std::optional<PipelineThreads> &pipeline, bool merge, AllocationStatistics &allocations) {
+    // Each image is read from its path and reported under its name
+    std::vector<std::filesystem::path> images;
+    std::vector<std::string> image_names;
 
-        for(auto &table : tables) {
-            std::fseek(f, 2 * swap_endian(table.count), SEEK_CUR);
+    std::error_code ec;
+    if(std::filesystem::is_directory(input, ec)) {
+        for(auto &entry : std::filesystem::directory_iterator(input, ec)) {
+            if(entry.is_regular_file() && is_image_extension(entry.path().extension().string())) {
+                images.emplace_back(entry.path());
+            }
         }
-    }
-
-    // Read characters
-    std::vector<FontCharacter> characters(256);
-    auto character_count = swap_endian(font.characters.count);
-
-    std::vector<FontCharacter> all_characters(character_count);
-    std::fread(all_characters.data(), character_count * sizeof(FontCharacter), 1, f);
-
-    for(auto &c : all_characters) {
-        auto character_index = swap_endian(c.character);
-        if(character_index < 256 && character_index > 0) {
-            characters[character_index] = c;
+        std::sort(images.begin(), images.end());
+        for(auto &image : images) {
+            image_names.emplace_back(image.filename().string());
         }
     }
-
-    // Lastly, finish the thing
-    std::uint32_t pixel_size = swap_endian(font.pixels.count);
-    std::vector<Monochrome> pixels(pixel_size);
-    std::fread(pixels.data(), pixel_size, 1, f);
-    std::fclose(f);
-
-    auto match = [&monochrome_version, &width](const MonochromeImage &text, std::uint32_t x, std::uint32_t y) -> float {
-        if(x + text.width > width || y + text.height > 480 || text.width == 0 || text.height == 0) {
-            return 0.0F;
+    else {
+        // - lists the images on standard input
+        std::ifstream list_file;
+        if(std::strcmp(input, "-") != 0) {
+            list_file.open(input);
+            if(!list_file.is_open()) {
+                eprintf("Failed to open %s for reading\n", input);
+                return EXIT_FAILURE;
+            }
         }
-
-        std::uint32_t hits = 0;
-        std::uint32_t total = text.height * text.width;
-
-        for(std::uint32_t ty = 0; ty < text.height; ty++) {
-            for(std::uint32_t tx = 0; tx < text.width; tx++) {
-                const auto &text_pixel = text.pixels[tx + ty * text.width];
-                const auto &image_pixel = monochrome_version[tx + x + (ty + y) * width];
-
-                std::int32_t difference = static_cast<std::int32_t>(text_pixel.intensity) - image_pixel.intensity;
-                if(difference < 0) {
-                    difference *= -1;
-                }
-
-                hits += (difference < 0x10);
+        std::istream &list = list_file.is_open() ? list_file : std::cin;
+        std::string line;
+        while(std::getline(list, line)) {
+            if(!line.empty()) {
+                images.emplace_back(line);
+                image_names.emplace_back(line);
             }
         }
+    }
 
-        return static_cast<float>(hits) / total;
-    };
+    if(images.empty()) {
+        eprintf("No images found in %s\n", input);
+        return EXIT_FAILURE;
+    }
 
-    // Load a names file
-    std::optional<std::vector<MonochromeImage>> names;
-    if(argc >= 5) {
-        for(std::size_t a = 4; a < argc; a++) {
-            std::ifstream input_stream(argv[a]);
-            if(!input_stream.is_open()) {
-                eprintf("Failed to open %s for reading\n", argv[a]);
-                return EXIT_FAILURE;
+    // Each worker reads with its own arena
+    std::vector<Reader> readers(std::max<std::size_t>(1, pipeline.has_value() ? pipeline->read : jobs ? jobs : std::thread::hardware_concurrency()));
+
+    // Read every image, calling done with the reader that read it. Images are either opened by the workers themselves,
+    // read into memory ahead of them so they don't wait on storage, or decoded and binarized by other threads.
+    std::optional<ReadAheadStatistics> read_ahead_statistics;
+    std::optional<PipelineStatistics> pipeline_statistics;
+    std::vector<ImageFailure> decode_failures;
+    std::mutex decode_failures_mutex;
+    auto read_images = [&](const std::function<void (Reader &reader, std::size_t job)> &done) {
+        if(pipeline.has_value()) {
+            std::vector<std::string> paths;
+            for(auto &image : images) {
+                paths.emplace_back(image.string());
             }
-            std::string line;
-            while(std::getline(input_stream, line)) {
-                if(!names.has_value()) {
-                    names = std::vector<MonochromeImage>();
+            pipeline_statistics = run_pipeline(paths, *pipeline, [&](std::size_t image, const CarnageError &error) {
+                std::lock_guard<std::mutex> lock(decode_failures_mutex);
+                decode_failures.push_back(ImageFailure { image, error });
+            }, [&](std::size_t image, const Screenshot &screenshot, std::size_t thread) {
+                auto &reader = readers[thread];
+                if(reader.read(recognizer, screenshot, image)) {
+                    done(reader, image);
                 }
-                filter_monochrome(names.value().emplace_back(draw_text(line.data(), pixels, characters, font)).pixels);
-            }
+            });
+            return;
         }
-    }
 
-    std::uint32_t name_x, name_y;
-    std::uint32_t score_x, score_y;
-    std::uint32_t kills_x, kills_y;
-    std::uint32_t assists_x, assists_y;
-    std::uint32_t deaths_x, deaths_y;
-
-    auto line_height_search = swap_endian(font.ascending_height);
-
-    auto find_header_text = [&pixels, &characters, &font, &match, &line_height_search, &width](const char *text, std::uint32_t min_x, std::uint32_t min_y, std::uint32_t &found_x, std::uint32_t &found_y) {
-        auto text_drawn = draw_text(text, pixels, characters, font);
-        filter_monochrome(text_drawn.pixels);
-
-        float found_percent = 0.0F;
-
-        for(std::uint32_t y = min_y; y < min_y + line_height_search; y++) {
-            for(std::uint32_t x = min_x; x < width; x++) {
-                float match_percent = match(text_drawn, x, y);
-                if(match_percent > found_percent) {
-                    found_percent = match_percent;
-                    found_x = x;
-                    found_y = y;
+        if(read_ahead_depth == 0) {
+            run_work_stealing(images.size(), readers.size(), [&](std::size_t job, std::size_t worker) {
+                auto &reader = readers[worker];
+                if(reader.read(recognizer, images[job].string().data(), job)) {
+                    done(reader, job);
                 }
-            }
+            });
+            return;
         }
 
-        if(found_percent < 0.85F) {
-            eprintf("Failed to find \"%s\". Best guess was %u,%u, but we only got a %f%% match.\n", text, found_x, found_y, found_percent * 100.0F);
-            std::exit(EXIT_FAILURE);
+        std::vector<std::string> paths;
+        for(auto &image : images) {
+            paths.emplace_back(image.string());
         }
+        read_ahead_statistics = read_ahead(paths, read_ahead_depth, readers.size(), [&](const FileContents &file, std::size_t worker) {
+            auto &reader = readers[worker];
+            if(file.error) {
+                auto message = format_message("Failed to load %s. Error was: %s", paths[file.file].data(), std::strerror(file.error));
+                reader.failures.push_back(ImageFailure { file.file, CarnageError(ErrorKind::DECODE_FAILED, message) });
+            }
+            else if(reader.read(recognizer, file.data.data(), file.data.size(), file.file)) {
+                done(reader, file.file);
+            }
+        });
     };
 
-    // Find the headers
-    find_header_text("Name", 120, 120, name_x, name_y);
-    find_header_text("Score", name_x, name_y - 10, score_x, score_y);
-    find_header_text("Kills", score_x, name_y - 10, kills_x, kills_y);
-    find_header_text("Assists", kills_x, name_y - 10, assists_x, assists_y);
-    find_header_text("Deaths", assists_x, name_y - 10, deaths_x, deaths_y);
+    if(merge) {
+        std::vector<std::vector<PlayerStats>> reports(images.size());
+        read_images([&reports](Reader &reader, std::size_t job) {
+            reports[job] = reader.players;
+        });
 
-    std::uint32_t y_cursor = name_y;
+        std::FILE *f = std::fopen(output, "wb");
+        if(!f) {
+            eprintf("Failed to open %s for writing\n", output);
+            return EXIT_FAILURE;
+        }
+        write_csv_header(f, true);
+        for(std::size_t i = 0; i < reports.size(); i++) {
+            write_csv(f, reports[i], image_names[i].data());
+        }
+        std::fclose(f);
+    }
+    else {
+        // Work out every output path up front so two images can't clobber the same CSV
+        std::vector<std::filesystem::path> outputs;
+        std::set<std::filesystem::path> unique_outputs;
+        for(auto &image : images) {
+            auto &csv = outputs.emplace_back(std::filesystem::path(output) / image.filename().replace_extension(".csv"));
+            if(!unique_outputs.insert(csv).second) {
+                eprintf("More than one image would be written to %s\n", csv.string().data());
+                return EXIT_FAILURE;
+            }
+        }
 
-    // Skip to the next line
-    auto skip_to_next_line = [&y_cursor, &monochrome_version, &line_height_search, &deaths_x, &width]() {
-        y_cursor += line_height_search / 2;
+        std::filesystem::create_directories(output, ec);
+        if(!std::filesystem::is_directory(output)) {
+            eprintf("Failed to create directory %s\n", output);
+            return EXIT_FAILURE;
+        }
 
-        while(y_cursor < 480) {
-            bool should_break = true;
+        read_images([&outputs](Reader &reader, std::size_t job) {
+            const auto &players = reader.players;
 
-            // See if there's anything this line. Checking deaths is fastest since it is rightmost
-            for(std::uint32_t x = deaths_x; x < width; x++) {
-                if(monochrome_version[x + y_cursor * width]) {
-                    should_break = false;
-                    break;
-                }
-            }
-            if(should_break) {
-                break;
+            std::FILE *f = std::fopen(outputs[job].string().data(), "wb");
+            if(!f) {
+                auto message = format_message("Failed to open %s for writing", outputs[job].string().data());
+                reader.failures.push_back(ImageFailure { job, CarnageError(ErrorKind::WRITE_FAILED, message) });
+                return;
             }
-            y_cursor++;
+            write_csv_header(f);
+            write_csv(f, players);
+            std::fclose(f);
+        });
+    }
+
+    int result = report_failures(readers, image_names, allocations, std::move(decode_failures));
+
+    // How busy each stage was, to balance the threads between them by
+    if(pipeline_statistics.has_value()) {
+        for(auto &stage : pipeline_statistics->stages) {
+            double available = stage.threads * pipeline_statistics->seconds;
+            eprintf("Pipeline %s: %zu thread%s, %.1f%% busy\n", stage.name, stage.threads, stage.threads == 1 ? "" : "s", available > 0 ? 100.0 * stage.busy_seconds / available : 0.0);
         }
-    };
+    }
 
-    skip_to_next_line();
+    // How much reading ahead kept the workers busy, to size the depth by
+    if(read_ahead_statistics.has_value()) {
+        auto &statistics = *read_ahead_statistics;
+        eprintf("Workers waited %.3f of %.3f seconds for reads (%.1f%%), reading up to %zu files ahead with %s\n", statistics.wait_seconds, statistics.worker_seconds, statistics.worker_seconds > 0 ? 100.0 * statistics.wait_seconds / statistics.worker_seconds : 0.0, read_ahead_depth, statistics.backend);
+    }
 
-    struct PlayerStats {
-        bool red;
-        std::string name;
-        std::int8_t score;
-        std::int8_t kills;
-        std::int8_t assists;
-        std::int8_t deaths;
-    };
+    return result;
+}
 
-    std::vector<PlayerStats> players;
+/** Images in an archive larger than this are reported as failures without being read, whatever their header claims */
+static constexpr std::uint64_t MAX_ARCHIVE_IMAGE_SIZE = 64 * 1024 * 1024;
 
-    // Generate some numbers to look for
-    std::vector<MonochromeImage> numbers(10);
-    for(std::size_t i = 0; i < numbers.size(); i++) {
-        char v[2] = {};
-        v[0] = static_cast<char>(i) + '0';
-        numbers[i] = draw_text(v, pixels, characters, font);
-        filter_monochrome(numbers[i].pixels);
+/**
+ * Read every image in a tar archive as it streams in, so it never has to be unpacked. Reading the archive overlaps with
+ * reading the images, but only a few images more than there are workers are held at once, however large the archive is.
+ * @param recognizer  recognizer
+ * @param input       path to the archive, or - for standard input
+ * @param output      directory to write a CSV to for each image, or the CSV to write every image to if merging
+ * @param jobs        number of images to read at once (0 uses the number of hardware threads)
+ * @param merge       write every image to one CSV, in archive order
+ * @param allocations statistics to add to
+ * @return            exit status
+ */
+static int run_tar_batch(const Recognizer &recognizer, const char *input, const char *output, std::size_t jobs, bool merge, AllocationStatistics &allocations) {
+    std::FILE *archive = stdin;
+    if(std::strcmp(input, "-") == 0) {
+        set_binary_standard_input();
     }
-    filter_monochrome(numbers.emplace_back(draw_text("-", pixels, characters, font)).pixels);
-
-    std::vector<MonochromeImage> all;
-    for(std::size_t i = 0; i < characters.size(); i++) {
-        if(characters[i].character_width && (i >= ' ' && i < 0x7F)) {
-            char v[2] = {};
-            v[0] = static_cast<char>(i);
-            filter_monochrome(all.emplace_back(draw_text(v, pixels, characters, font)).pixels);
-        }
+    else if(!(archive = std::fopen(input, "rb"))) {
+        eprintf("Failed to open %s for reading\n", input);
+        return EXIT_FAILURE;
     }
 
-    // Go through each line
-    while(true) {
-        // See if there's something on this line. Checking deaths is fastest since it's the rightmost
-        bool found_something = false;
-        for(std::uint32_t y = y_cursor; y < y_cursor + line_height_search && !found_something; y++) {
-            for(std::uint32_t x = deaths_x; x < width && !found_something; x++) {
-                found_something = monochrome_version[x + y * width].intensity > 0;
-            }
+    auto close_archive = [&]() {
+        if(archive != stdin) {
+            std::fclose(archive);
         }
+    };
 
-        if(!found_something) {
-            break;
+    std::FILE *merged = nullptr;
+    if(merge) {
+        if(!(merged = std::fopen(output, "wb"))) {
+            eprintf("Failed to open %s for writing\n", output);
+            close_archive();
+            return EXIT_FAILURE;
+        }
+        write_csv_header(merged, true);
+    }
+    else {
+        std::error_code ec;
+        std::filesystem::create_directories(output, ec);
+        if(!std::filesystem::is_directory(output)) {
+            eprintf("Failed to create directory %s\n", output);
+            close_archive();
+            return EXIT_FAILURE;
         }
+    }
 
-        // Let's get some numbers
-        auto string_at = [&match, &width, &line_height_search, &monochrome_version, &pixels, &characters, &font](std::uint32_t search_x, std::uint32_t search_y, std::uint32_t end_x, const std::vector<MonochromeImage> &table, bool fix_string = false) -> std::string {
-            std::uint32_t x = search_x;
+    struct Member {
+        std::size_t image;
+        std::string name;
+        std::vector<std::byte> data;
+        std::filesystem::path output;
+    };
 
-            // Get the length of the string
-            std::uint32_t max_x;
-            std::uint32_t drought = 0;
-            for(max_x = x + 1; max_x < end_x; max_x++) {
-                drought++;
-                for(std::uint32_t y = search_y + 4; y < search_y + line_height_search; y++) {
-                    if(monochrome_version[max_x + y * width].intensity) {
-                        drought = 0;
-                        break;
-                    }
+    std::vector<Reader> readers(std::max<std::size_t>(1, jobs ? jobs : std::thread::hardware_concurrency()));
+    std::size_t window = readers.size() * 2;
+    JobQueue<Member> queue;
+
+    // Members being read, or read but waiting for the members before them to be written to the merged CSV
+    std::mutex mutex;
+    std::condition_variable member_done;
+    std::size_t in_flight = 0;
+    std::map<std::size_t, std::pair<std::string, std::vector<PlayerStats>>> finished;
+    std::size_t next_to_write = 0;
+
+    // Called once for every member that was let in, whether or not it was read
+    auto member_finished = [&](std::size_t image, std::string name, const std::vector<PlayerStats> *players) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(merge) {
+                // Write in archive order, whichever worker finishes first
+                auto &report = finished[image];
+                report.first = std::move(name);
+                if(players) {
+                    report.second = *players;
                 }
+                for(auto next = finished.begin(); next != finished.end() && next->first == next_to_write; next = finished.erase(next)) {
+                    write_csv(merged, next->second.second, next->second.first.data());
+                    next_to_write++;
+                    in_flight--;
+                }
+            }
+            else {
+                in_flight--;
             }
-            max_x -= drought;
-
-            std::string final_string;
-
-            while(x < max_x) {
-                float best_character_percent = 0.0F;
-                char best_character;
-                std::optional<std::uint32_t> best_length;
-                std::uint32_t best_x;
-
-                // Give some leeway for a few pixels
-                for(std::int32_t my = -3; my < 4; my++) {
-                    for(std::int32_t mx = -3; mx < 4; mx++) {
-                        for(auto &c : table) {
-                            if(x + c.width * 0.5F > max_x) {
-                                continue;
-                            }
-
-                            float test = match(c, x + mx, search_y + my);
-                            if(test > best_character_percent) {
-                                best_character_percent = test;
-                                best_character = c.text[0];
-                                best_length = c.width;
-                                best_x = mx;
-                            }
-                        }
+        }
+        member_done.notify_one();
+    };
+
+    std::vector<std::thread> workers;
+    for(auto &reader : readers) {
+        workers.emplace_back([&, &reader = reader]() {
+            while(auto member = queue.pop()) {
+                bool read = reader.read(recognizer, member->data.data(), member->data.size(), member->image);
+                member->data = {};
+
+                if(!merge && read) {
+                    std::FILE *f = std::fopen(member->output.string().data(), "wb");
+                    if(f) {
+                        write_csv_header(f);
+                        write_csv(f, reader.players);
+                        std::fclose(f);
+                    }
+                    else {
+                        auto message = format_message("Failed to open %s for writing", member->output.string().data());
+                        reader.failures.push_back(ImageFailure { member->image, CarnageError(ErrorKind::WRITE_FAILED, message) });
                     }
                 }
 
-                if(!best_length.has_value()) {
-                    break;
+                member_finished(member->image, std::move(member->name), read ? &reader.players : nullptr);
+            }
+        });
+    }
+
+    // Only images are read; everything else in the archive is skipped over
+    std::vector<std::string> image_names;
+    std::vector<ImageFailure> failures;
+    std::set<std::filesystem::path> unique_outputs;
+    std::optional<CarnageError> archive_error;
+    try {
+        TarReader tar(archive);
+        std::string name;
+        std::uint64_t size;
+        while(tar.next(name, size)) {
+            std::filesystem::path path(name);
+            if(!is_image_extension(path.extension().string())) {
+                continue;
+            }
+
+            std::size_t image = image_names.size();
+            image_names.push_back(name);
+            std::filesystem::path csv;
+            if(!merge) {
+                csv = std::filesystem::path(output) / path.filename().replace_extension(".csv");
+                if(!unique_outputs.insert(csv).second) {
+                    auto message = format_message("More than one image would be written to %s", csv.string().data());
+                    failures.push_back(ImageFailure { image, CarnageError(ErrorKind::WRITE_FAILED, message) });
+                    continue;
                 }
+            }
 
-                x += best_length.value();
-                final_string += best_character;
+            // Wait for room before reading the image so memory doesn't grow with the archive
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                member_done.wait(lock, [&]() {
+                    return in_flight < window;
+                });
+                in_flight++;
             }
 
-            // Strip off whitespace at the end
-            while(final_string.size() && final_string[final_string.size() - 1] == ' ') {
-                final_string.erase(final_string.end() - 1);
+            // Don't trust the header's size with an allocation; the next member is found by skipping over this one
+            if(size > MAX_ARCHIVE_IMAGE_SIZE) {
+                auto message = format_message("Images can't be larger than %" PRIu64 " bytes, but this one is %" PRIu64 " bytes", MAX_ARCHIVE_IMAGE_SIZE, size);
+                failures.push_back(ImageFailure { image, CarnageError(ErrorKind::DECODE_FAILED, message) });
+                member_finished(image, name, nullptr);
+                continue;
             }
 
-            // Fix some common errors if we're looking for names
-            for(std::size_t i = 0; fix_string && i < final_string.size(); i++) {
-                auto fix_error = [&i, &final_string, &pixels, &characters, &font, &match, &search_x, &search_y](char a, char b) {
-                    char &output = final_string[i];
-                    if(output != a && output != b) {
-                        return;
-                    }
+            Member member { image, name, {}, std::move(csv) };
+            try {
+                member.data.resize(static_cast<std::size_t>(size));
+                tar.read(member.data.data());
+            }
+            catch(CarnageError &e) {
+                // Nothing past here can be read, but the image the archive stopped in is still reported
+                failures.push_back(ImageFailure { image, e });
+                throw;
+            }
+            catch(std::exception &e) {
+                failures.push_back(ImageFailure { image, make_read_error(e) });
+                throw;
+            }
+            queue.push(std::move(member));
+        }
+    }
+    catch(CarnageError &e) {
+        archive_error = e;
+    }
+    catch(std::exception &e) {
+        archive_error = make_read_error(e);
+    }
 
-                    output = a;
-                    auto drawn_text_a = draw_text(final_string.data(), pixels, characters, font);
-                    filter_monochrome(drawn_text_a.pixels);
+    queue.close();
+    for(auto &worker : workers) {
+        worker.join();
+    }
+    close_archive();
+    if(merged) {
+        std::fclose(merged);
+    }
 
-                    output = b;
-                    auto drawn_text_b = draw_text(final_string.data(), pixels, characters, font);
-                    filter_monochrome(drawn_text_b.pixels);
+    int result = report_failures(readers, image_names, allocations, std::move(failures));
+    if(archive_error.has_value()) {
+        eprintf("Stopped reading %s: %s\n", input, archive_error->what());
+        result = EXIT_FAILURE;
+    }
+    return result;
+}
 
-                    float match_a = match(drawn_text_a, search_x, search_y);
-                    float match_b = match(drawn_text_b, search_x, search_y);
+/** Most threads --jobs or any stage of --pipeline can ask for */
+static constexpr std::size_t MAX_THREADS = 1024;
 
-                    if(match_a > match_b) {
-                        output = a;
-                    }
-                    else {
-                        output = b;
-                    }
-                };
-
-                fix_error('l', 'i');
-                fix_error('I', 'i');
-                fix_error('I', 'l');
-                fix_error('2', 'Z');
-                fix_error('a', 'e');
-                fix_error('n', 'm');
-            }
+/** Most files --read-ahead can keep in flight; without io_uring, each one gets a thread */
+static constexpr std::size_t MAX_READ_AHEAD_DEPTH = 1024;
 
+/** Most requests --queue-depth can hold */
+static constexpr std::size_t MAX_QUEUE_DEPTH = 65536;
 
-            return final_string;
-        };
+/**
+ * Parse a positive count from a command line argument
+ * @param text    text to parse, which has to start with a digit
+ * @param maximum largest count allowed
+ * @param count   set to the count
+ * @param end     set to the character after the count; if null, the count has to be the whole text
+ * @return        true if the count is from 1 to maximum
+ */
+static bool parse_count(const char *text, std::size_t maximum, std::size_t &count, const char **end = nullptr) {
+    // strtoull would skip whitespace and wrap negative numbers around
+    if(!std::isdigit(static_cast<unsigned char>(*text))) {
+        return false;
+    }
 
-        auto &player = players.emplace_back();
+    char *after;
+    errno = 0;
+    unsigned long long value = std::strtoull(text, &after, 10);
+    if(errno == ERANGE || value == 0 || value > maximum || (!end && *after)) {
+        return false;
+    }
+    if(end) {
+        *end = after;
+    }
+    count = static_cast<std::size_t>(value);
+    return true;
+}
 
-        // Determine if it was red or blue
-        bool found = false;
-        for(std::uint32_t y = y_cursor; y < y_cursor + line_height_search; y++) {
-            for(std::uint32_t x = name_x; x < kills_x && !found; x++) {
-                if(monochrome_version[x + width * y].intensity > 0x7F) {
-                    auto &pixel = image_data[x + width * y];
-                    if(Monochrome(pixel).intensity > 0x7F) {
-                        player.red = pixel.red > pixel.blue;
-                        found = true;
-                        break;
-                    }
-                }
+static int run(int argc, const char **argv) {
+    bool batch = false;
+    bool merge = false;
+    bool tar = false;
+    bool serve = false;
+    bool stats = false;
+    bool builtin_font = false;
+    RecognizerOptions options;
+    const char *font_cache = nullptr;
+    const char *roster_cache = nullptr;
+    std::size_t jobs = 0;
+    std::size_t read_ahead_depth = 0;
+    std::optional<PipelineThreads> pipeline;
+    const char *listen_path = nullptr;
+    std::size_t queue_depth = 0;
+    std::vector<const char *> arguments;
+
+    for(int a = 1; a < argc; a++) {
+        if(std::strcmp(argv[a], "--batch") == 0) {
+            batch = true;
+        }
+        else if(std::strcmp(argv[a], "--merge") == 0) {
+            merge = true;
+        }
+        else if(std::strcmp(argv[a], "--tar") == 0) {
+            tar = true;
+        }
+        else if(std::strcmp(argv[a], "--serve") == 0) {
+            serve = true;
+        }
+        else if(std::strcmp(argv[a], "--stats") == 0) {
+            stats = true;
+        }
+        #ifdef CARNAGE_REPORTER_BUILTIN_FONT
+        else if(std::strcmp(argv[a], "--builtin-font") == 0) {
+            builtin_font = true;
+        }
+        #endif
+        else if(std::strcmp(argv[a], "--roster-decoding") == 0) {
+            options.roster_decoding = true;
+        }
+        else if(std::strcmp(argv[a], "--dp-decoding") == 0) {
+            options.dp_decoding = true;
+        }
+        else if(std::strcmp(argv[a], "--font-cache") == 0 && a + 1 < argc) {
+            font_cache = argv[++a];
+        }
+        else if(std::strcmp(argv[a], "--roster-cache") == 0 && a + 1 < argc) {
+            roster_cache = argv[++a];
+        }
+        else if(std::strcmp(argv[a], "--pipeline") == 0 && a + 1 < argc) {
+            const char *end;
+            PipelineThreads threads = {};
+            bool valid = parse_count(argv[++a], MAX_THREADS, threads.decode, &end) && *end == ',';
+            valid = valid && parse_count(end + 1, MAX_THREADS, threads.binarize, &end) && *end == ',';
+            valid = valid && parse_count(end + 1, MAX_THREADS, threads.read);
+            if(!valid) {
+                eprintf("Invalid pipeline thread counts %s; expected three numbers from 1 to %zu such as 2,1,6\n", argv[a], MAX_THREADS);
+                return EXIT_FAILURE;
             }
+            pipeline = threads;
         }
-
-        // Use a names file
-        if(names.has_value() && names.value().size()) {
-            float best_match_percent = 0.0F;
-            std::size_t best_match_index = 0;
-
-            for(std::int32_t my = -2; my < 3; my++) {
-                for(std::int32_t mx = -2; mx < 3; mx++) {
-                    for(std::size_t i = 0; i < names.value().size(); i++) {
-                        float match_percent = match(names.value()[i], name_x + mx, y_cursor + my);
-                        if(best_match_percent < match_percent) {
-                            best_match_percent = match_percent;
-                            best_match_index = i;
-                        }
-                    }
-                }
+        else if(std::strcmp(argv[a], "--read-ahead") == 0 && a + 1 < argc) {
+            if(!parse_count(argv[++a], MAX_READ_AHEAD_DEPTH, read_ahead_depth)) {
+                eprintf("Invalid read-ahead depth %s; expected 1 to %zu\n", argv[a], MAX_READ_AHEAD_DEPTH);
+                return EXIT_FAILURE;
             }
-
-            // Use the name from the names file if it's close enough
-            if(best_match_percent > 0.80F) {
-                player.name = names.value()[best_match_index].text;
-                names.value().erase(names.value().begin() + best_match_index);
+        }
+        else if(std::strcmp(argv[a], "--jobs") == 0 && a + 1 < argc) {
+            if(!parse_count(argv[++a], MAX_THREADS, jobs)) {
+                eprintf("Invalid job count %s; expected 1 to %zu\n", argv[a], MAX_THREADS);
+                return EXIT_FAILURE;
             }
-            else {
-                player.name = string_at(name_x, y_cursor, score_x, all, true);
+        }
+        #ifdef CARNAGE_REPORTER_SOCKET_SERVICE
+        else if(std::strcmp(argv[a], "--listen") == 0 && a + 1 < argc) {
+            listen_path = argv[++a];
+        }
+        else if(std::strcmp(argv[a], "--queue-depth") == 0 && a + 1 < argc) {
+            if(!parse_count(argv[++a], MAX_QUEUE_DEPTH, queue_depth)) {
+                eprintf("Invalid queue depth %s; expected 1 to %zu\n", argv[a], MAX_QUEUE_DEPTH);
+                return EXIT_FAILURE;
             }
         }
+        #endif
+        else if(std::strncmp(argv[a], "--", 2) == 0) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
         else {
-            player.name = string_at(name_x, y_cursor, score_x, all, true);
+            arguments.push_back(argv[a]);
         }
+    }
 
-        player.score = std::strtol(string_at(score_x, y_cursor, kills_x, numbers).data(), nullptr, 10);
-        player.kills = std::strtol(string_at(kills_x, y_cursor, assists_x, numbers).data(), nullptr, 10);
-        player.assists = std::strtol(string_at(assists_x, y_cursor, deaths_x, numbers).data(), nullptr, 10);
-        player.deaths = std::strtol(string_at(deaths_x, y_cursor, width, numbers).data(), nullptr, 10);
-
-        skip_to_next_line();
+    // The font tag argument is left out when the built-in font is used, and servers take their images and outputs from
+    // requests instead
+    bool server = serve || listen_path;
+    std::size_t font_arguments = builtin_font ? 0 : 1;
+    std::size_t path_arguments = server ? 0 : 2;
+    if(arguments.size() < path_arguments + font_arguments || (!batch && !server && (merge || jobs)) || (tar && !batch) || (read_ahead_depth && (!batch || tar)) || (pipeline.has_value() && (!batch || tar || jobs || read_ahead_depth)) || (server && (batch || merge)) || (serve && listen_path) || (queue_depth && !listen_path) || (builtin_font && font_cache)) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
     }
+    const char *input = server ? nullptr : arguments[0];
+    const char *output_path = server ? nullptr : arguments[1 + font_arguments];
+    const char *font_path = builtin_font ? nullptr : arguments[server ? 0 : 1];
 
-    // Determine if it's free-for-all
-    bool ffa = true;
-    for(auto &player : players) {
-        if(player.red) {
-            ffa = false;
-            break;
+    // Load a names file
+    std::vector<std::string> names;
+    for(std::size_t a = path_arguments + font_arguments; a < arguments.size(); a++) {
+        if(!read_names_file(arguments[a], names)) {
+            eprintf("Failed to open %s for reading\n", arguments[a]);
+            return EXIT_FAILURE;
         }
     }
 
-    // Determine what place people are in
-    std::vector<std::size_t> places;
-    for(auto &player : players) {
-        std::size_t players_below = 0;
-        for(auto &player_test : players) {
-            if(&player == &player_test) {
-                continue;
+    std::optional<CompiledFont> font;
+    if(builtin_font) {
+        #ifdef CARNAGE_REPORTER_BUILTIN_FONT
+        font = CompiledFont::from_memory(reinterpret_cast<const std::byte *>(BUILTIN_FONT), sizeof(BUILTIN_FONT));
+        #endif
+        if(!font.has_value()) {
+            eprintf("The built-in font is invalid; it may have been built for a different byte order\n");
+            return EXIT_FAILURE;
+        }
+    }
+    else {
+        // Compile the font unless an up-to-date compiled copy is already cached
+        auto font_data = read_font_file(font_path);
+        if(font_cache) {
+            font = CompiledFont::load(font_cache, hash_bytes(font_data.data(), font_data.size()));
+        }
+        if(!font.has_value()) {
+            font = CompiledFont::compile(parse_font(font_data));
+            if(font_cache && !font->save(font_cache)) {
+                eprintf("Failed to write %s; continuing without it\n", font_cache);
             }
-
-            #define CHECK_STAT(stat, good_operator, bad_operator) if(player.stat good_operator player_test.stat) {continue;} else if(player.stat bad_operator player_test.stat) {players_below++; continue;}
-
-            CHECK_STAT(score, >, <);
-            CHECK_STAT(kills, >, <);
-            CHECK_STAT(deaths, <, >);
-            CHECK_STAT(assists, >, <);
-
-            #undef CHECK_STAT
-
-            players_below++;
         }
+    }
 
-        places.push_back(players_below + 1);
+    // Render the names, reusing whatever a cached roster already has
+    std::optional<Roster> roster;
+    if(roster_cache) {
+        roster = Roster::load(roster_cache, font->get_source_hash());
+    }
+    if(!roster.has_value() || !roster->has_names(names)) {
+        roster = Roster::render(*font, names, roster.has_value() ? &*roster : nullptr);
+        if(roster_cache && !roster->save(roster_cache)) {
+            eprintf("Failed to write %s; continuing without it\n", roster_cache);
+        }
     }
 
-    // Begin
-    std::FILE *output = std::fopen(argv[3], "wb");
-    std::fprintf(output, "name,place,team,score,kills,assists,deaths\n");
-    PlayerStats teams[2] = {};
-    for(std::size_t p = 0; p < players.size(); p++) {
-        auto &place = places[p];
-        auto &player = players[p];
-        const char *th = "th";
+    // Render everything once
+    Recognizer recognizer(std::move(*font), std::move(*roster), options);
 
-        if((place % 100) < 10 || (place % 100) >= 19) {
-            switch(place % 10) {
-                case 1:
-                    th = "st";
-                    break;
-                case 2:
-                    th = "nd";
-                    break;
-                case 3:
-                    th = "rd";
-                    break;
-                default:
-                    break;
-            }
+    int result = EXIT_SUCCESS;
+    AllocationStatistics allocations;
+    if(serve) {
+        result = run_server(recognizer, jobs);
+    }
+    #ifdef CARNAGE_REPORTER_SOCKET_SERVICE
+    else if(listen_path) {
+        result = run_socket_service(recognizer, listen_path, jobs, queue_depth);
+    }
+    #endif
+    else if(batch && tar) {
+        result = run_tar_batch(recognizer, input, output_path, jobs, merge, allocations);
+    }
+    else if(batch) {
+        result = run_batch(recognizer, input, output_path, jobs, read_ahead_depth, pipeline, merge, allocations);
+    }
+    else {
+        Reader reader;
+        if(!reader.read(recognizer, input)) {
+            eprintf("%s\n", reader.failures[0].error.what());
+            return EXIT_FAILURE;
         }
+        allocations = reader.allocations;
+        const auto &players = reader.players;
 
-        // Write it!
-        std::fprintf(
-            output,
-            "%s,%zu%s,%s,%i,%i,%i,%i\n",
-            player.name.data(),
-            place,
-            th,
-            ffa ? "ffa" : (player.red ? "red" : "blue"),
-            player.score,
-            player.kills,
-            player.assists,
-            player.deaths
-        );
+        std::FILE *output = std::fopen(output_path, "wb");
+        if(!output) {
+            eprintf("Failed to open %s for writing\n", output_path);
+            return EXIT_FAILURE;
+        }
+        write_csv_header(output);
+        write_csv(output, players);
+        std::fclose(output);
+    }
 
-        // Tally up scores
-        auto &team = teams[player.red];
-        team.score += player.score;
-        team.kills += player.kills;
-        team.assists += player.assists;
-        team.deaths += player.deaths;
+    if(stats) {
+        print_match_statistics(recognizer.get_match_statistics());
+        print_allocation_statistics(allocations);
     }
 
-    #define PRINT_TEAM_TOTAL(team_name, team_index) std::fprintf(output, team_name ",%s,%s,%i,%i,%i,%i\n", teams[team_index].score > teams[!team_index].score ? "1st" : "2nd", team_index ? "red" : "blue", teams[team_index].score, teams[team_index].kills, teams[team_index].assists, teams[team_index].deaths);
+    return result;
+}
 
-    if(!ffa) {
-        PRINT_TEAM_TOTAL("red_team_total", 1);
-        PRINT_TEAM_TOTAL("blue_team_total", 0);
+int main(int argc, const char **argv) {
+    try {
+        return run(argc, argv);
+    }
+    catch(CarnageError &e) {
+        eprintf("%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    catch(std::exception &e) {
+        // Loading fonts and names can run out of memory or fail in the standard library, too
+        eprintf("%s\n", make_read_error(e).what());
+        return EXIT_FAILURE;
     }
-
-    #undef PRINT_TEAM_TOTAL
 }
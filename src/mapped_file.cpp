@@ -0,0 +1,138 @@
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.hpp"
+
+bool MappedFile::open(const char *path) {
+    this->close();
+
+    #ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if(!mapping) {
+        return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(!view) {
+        return false;
+    }
+    this->mapping = reinterpret_cast<const std::byte *>(view);
+    this->mapping_size = static_cast<std::size_t>(size.QuadPart);
+    #else
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void *view = mmap(nullptr, static_cast<std::size_t>(file_stat.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(view == MAP_FAILED) {
+        return false;
+    }
+    this->mapping = reinterpret_cast<const std::byte *>(view);
+    this->mapping_size = static_cast<std::size_t>(file_stat.st_size);
+    #endif
+
+    return true;
+}
+
+void MappedFile::close() {
+    if(this->mapping) {
+        #ifdef _WIN32
+        UnmapViewOfFile(this->mapping);
+        #else
+        munmap(const_cast<std::byte *>(this->mapping), this->mapping_size);
+        #endif
+        this->mapping = nullptr;
+        this->mapping_size = 0;
+    }
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if(this != &other) {
+        this->close();
+        this->mapping = std::exchange(other.mapping, nullptr);
+        this->mapping_size = std::exchange(other.mapping_size, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    this->close();
+}
+
+bool replace_file(const char *path, const std::byte *data, std::size_t size) {
+    // Each writer gets a temporary file of its own, so processes writing the same file at once can't rename each other's
+    // half-written files into place
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    std::FILE *f = nullptr;
+
+    #ifdef _WIN32
+    char temporary_name[MAX_PATH];
+    if(GetTempFileNameA(directory.empty() ? "." : directory.string().data(), "crt", 0, temporary_name) == 0) {
+        return false;
+    }
+    std::string temporary_path = temporary_name;
+    f = std::fopen(temporary_path.data(), "wb");
+    #else
+    std::string temporary_path = std::string(path) + ".XXXXXX";
+    int fd = mkstemp(temporary_path.data());
+    if(fd < 0) {
+        return false;
+    }
+
+    // mkstemp() makes the file private to its owner, but the file it replaces wasn't
+    fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    f = fdopen(fd, "wb");
+    if(!f) {
+        ::close(fd);
+    }
+    #endif
+
+    std::error_code ec;
+    if(!f) {
+        std::filesystem::remove(temporary_path, ec);
+        return false;
+    }
+    bool written = std::fwrite(data, 1, size, f) == size;
+    written = (std::fclose(f) == 0) && written;
+
+    if(written) {
+        std::filesystem::rename(temporary_path, path, ec);
+    }
+    if(!written || ec) {
+        std::filesystem::remove(temporary_path, ec);
+        return false;
+    }
+    return true;
+}
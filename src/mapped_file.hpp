@@ -0,0 +1,62 @@
+#ifndef CARNAGE_REPORTER__MAPPED_FILE_HPP
+#define CARNAGE_REPORTER__MAPPED_FILE_HPP
+
+#include <cstddef>
+
+/**
+ * A file mapped read-only into memory. Processes mapping the same file share the same pages.
+ */
+class MappedFile {
+public:
+    /**
+     * Map a file
+     * @param path path to the file
+     * @return     true if the file was mapped
+     */
+    bool open(const char *path);
+
+    /**
+     * Unmap the file, if one is mapped
+     */
+    void close();
+
+    /**
+     * Get the contents of the file
+     * @return contents, or nullptr if nothing is mapped
+     */
+    const std::byte *data() const {
+        return this->mapping;
+    }
+
+    /**
+     * Get the size of the file
+     * @return size in bytes
+     */
+    std::size_t size() const {
+        return this->mapping_size;
+    }
+
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    ~MappedFile();
+
+private:
+    const std::byte *mapping = nullptr;
+    std::size_t mapping_size = 0;
+};
+
+/**
+ * Write a file in one step by writing a uniquely named temporary file next to it and renaming it over the old one, so
+ * nothing ever maps a partially written file, processes that have the old one mapped are not disturbed, and processes
+ * writing the same file at once each put a whole file in place
+ * @param path path to the file
+ * @param data contents
+ * @param size size of the contents in bytes
+ * @return     true if the file was written
+ */
+bool replace_file(const char *path, const std::byte *data, std::size_t size);
+
+#endif
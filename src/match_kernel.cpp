@@ -0,0 +1,87 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "match_kernel.hpp"
+#include "bit_image.hpp"
+
+std::uint32_t count_misses_scalar(const std::uint64_t *image_column, std::uint32_t image_height, const std::uint64_t *text_column, std::uint32_t text_height, std::uint32_t text_columns, std::uint64_t last_column_mask, std::uint32_t shift, std::uint32_t miss_limit, std::uint32_t &rows_compared) {
+    std::uint32_t misses = 0;
+    rows_compared = 0;
+
+    // Line up each word of the template with the 64 pixels of the image under it, then count the differing bits
+    for(std::uint32_t column = 0; column < text_columns; column++) {
+        std::uint64_t mask = column + 1 == text_columns ? last_column_mask : ~std::uint64_t(0);
+        const auto *low = image_column;
+        const auto *high = image_column + image_height;
+
+        for(std::uint32_t band = 0; band < text_height; band += MATCH_KERNEL_BAND) {
+            std::uint32_t band_end = band + MATCH_KERNEL_BAND < text_height ? band + MATCH_KERNEL_BAND : text_height;
+            for(std::uint32_t ty = band; ty < band_end; ty++) {
+                std::uint64_t pixels = shift ? ((low[ty] >> shift) | (high[ty] << (64 - shift))) : low[ty];
+                misses += popcount64((pixels ^ text_column[ty]) & mask);
+            }
+
+            rows_compared += band_end - band;
+            if(misses > miss_limit) {
+                return misses;
+            }
+        }
+
+        image_column += image_height;
+        text_column += text_height;
+    }
+
+    return misses;
+}
+
+namespace {
+    struct KernelChoice {
+        MatchKernel kernel;
+        const char *name;
+    };
+
+    KernelChoice choose_kernel() {
+        KernelChoice kernels[4] = {};
+        std::size_t kernel_count = 0;
+
+        // Fastest first
+        #ifdef CARNAGE_REPORTER_X86_KERNELS
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512bw")) {
+            kernels[kernel_count++] = { count_misses_avx512bw, "avx512bw" };
+        }
+        if(__builtin_cpu_supports("avx2")) {
+            kernels[kernel_count++] = { count_misses_avx2, "avx2" };
+        }
+        if(__builtin_cpu_supports("sse2")) {
+            kernels[kernel_count++] = { count_misses_sse2, "sse2" };
+        }
+        #endif
+        kernels[kernel_count++] = { count_misses_scalar, "scalar" };
+
+        // Let the user pick a slower kernel (handy for checking that every kernel gives the same results)
+        const char *forced = std::getenv("CARNAGE_REPORTER_KERNEL");
+        if(forced) {
+            for(std::size_t k = 0; k < kernel_count; k++) {
+                if(std::strcmp(forced, kernels[k].name) == 0) {
+                    return kernels[k];
+                }
+            }
+        }
+
+        return kernels[0];
+    }
+
+    const KernelChoice &kernel_choice() {
+        static const KernelChoice choice = choose_kernel();
+        return choice;
+    }
+}
+
+MatchKernel get_match_kernel() {
+    return kernel_choice().kernel;
+}
+
+const char *get_match_kernel_name() {
+    return kernel_choice().name;
+}
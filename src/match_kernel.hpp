@@ -0,0 +1,49 @@
+#ifndef CARNAGE_REPORTER__MATCH_KERNEL_HPP
+#define CARNAGE_REPORTER__MATCH_KERNEL_HPP
+
+#include <cstdint>
+
+/**
+ * Number of rows compared between checks of the miss limit. Every kernel stops at the same points, so how much work was
+ * skipped doesn't depend on which kernel is used.
+ */
+static constexpr std::uint32_t MATCH_KERNEL_BAND = 8;
+
+/**
+ * Count the pixels of a packed template that differ from a packed image under it. Each word column is compared in
+ * bands of MATCH_KERNEL_BAND rows, and the count stops early once it passes the miss limit.
+ * @param image_column     first word of the image under the template, with the next word column image_height words after
+ * @param image_height     number of rows in each word column of the image
+ * @param text_column      first word of the template
+ * @param text_height      number of rows in the template
+ * @param text_columns     number of word columns in the template
+ * @param last_column_mask mask of the valid bits of the last word column of the template
+ * @param shift            bit offset of the template within the image words (0-63)
+ * @param miss_limit       stop after any band where more than this many pixels differ
+ * @param rows_compared    set to the number of rows compared, counting each word column separately
+ * @return                 number of differing pixels, or at least miss_limit + 1 if stopped early
+ */
+using MatchKernel = std::uint32_t (*)(const std::uint64_t *image_column, std::uint32_t image_height, const std::uint64_t *text_column, std::uint32_t text_height, std::uint32_t text_columns, std::uint64_t last_column_mask, std::uint32_t shift, std::uint32_t miss_limit, std::uint32_t &rows_compared);
+
+std::uint32_t count_misses_scalar(const std::uint64_t *image_column, std::uint32_t image_height, const std::uint64_t *text_column, std::uint32_t text_height, std::uint32_t text_columns, std::uint64_t last_column_mask, std::uint32_t shift, std::uint32_t miss_limit, std::uint32_t &rows_compared);
+
+#ifdef CARNAGE_REPORTER_X86_KERNELS
+std::uint32_t count_misses_sse2(const std::uint64_t *image_column, std::uint32_t image_height, const std::uint64_t *text_column, std::uint32_t text_height, std::uint32_t text_columns, std::uint64_t last_column_mask, std::uint32_t shift, std::uint32_t miss_limit, std::uint32_t &rows_compared);
+std::uint32_t count_misses_avx2(const std::uint64_t *image_column, std::uint32_t image_height, const std::uint64_t *text_column, std::uint32_t text_height, std::uint32_t text_columns, std::uint64_t last_column_mask, std::uint32_t shift, std::uint32_t miss_limit, std::uint32_t &rows_compared);
+std::uint32_t count_misses_avx512bw(const std::uint64_t *image_column, std::uint32_t image_height, const std::uint64_t *text_column, std::uint32_t text_height, std::uint32_t text_columns, std::uint64_t last_column_mask, std::uint32_t shift, std::uint32_t miss_limit, std::uint32_t &rows_compared);
+#endif
+
+/**
+ * Get the fastest kernel the CPU supports. This is checked once with CPUID. Setting the CARNAGE_REPORTER_KERNEL
+ * environment variable to scalar, sse2, avx2, or avx512bw forces a kernel if the CPU supports it.
+ * @return kernel
+ */
+MatchKernel get_match_kernel();
+
+/**
+ * Get the name of the kernel returned by get_match_kernel()
+ * @return name
+ */
+const char *get_match_kernel_name();
+
+#endif
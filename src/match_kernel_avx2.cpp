@@ -0,0 +1,66 @@
+#include <immintrin.h>
+
+#include "match_kernel.hpp"
+
+static_assert(MATCH_KERNEL_BAND == 8, "the AVX2 kernel handles a band as two vectors of four rows");
+
+// Count the set bits of each 64-bit lane with a nibble lookup table
+static inline __m256i popcount_epi64(__m256i v) {
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(v, nibble));
+    __m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+    return _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256());
+}
+
+std::uint32_t count_misses_avx2(const std::uint64_t *image_column, std::uint32_t image_height, const std::uint64_t *text_column, std::uint32_t text_height, std::uint32_t text_columns, std::uint64_t last_column_mask, std::uint32_t shift, std::uint32_t miss_limit, std::uint32_t &rows_compared) {
+    // Shifting a lane left by 64 clears it, so shift == 0 needs no special case
+    const __m128i shift_right = _mm_cvtsi32_si128(static_cast<int>(shift));
+    const __m128i shift_left = _mm_cvtsi32_si128(static_cast<int>(64 - shift));
+    const __m256i lane = _mm256_setr_epi64x(0, 1, 2, 3);
+    std::uint32_t misses = 0;
+    rows_compared = 0;
+
+    for(std::uint32_t column = 0; column < text_columns; column++) {
+        std::uint64_t mask_word = column + 1 == text_columns ? last_column_mask : ~std::uint64_t(0);
+        const __m256i mask = _mm256_set1_epi64x(static_cast<long long>(mask_word));
+        const auto *low = reinterpret_cast<const long long *>(image_column);
+        const auto *high = reinterpret_cast<const long long *>(image_column + image_height);
+        const auto *text = reinterpret_cast<const long long *>(text_column);
+
+        for(std::uint32_t band = 0; band < text_height; band += MATCH_KERNEL_BAND) {
+            std::uint32_t band_end = band + MATCH_KERNEL_BAND < text_height ? band + MATCH_KERNEL_BAND : text_height;
+            __m256i band_misses = _mm256_setzero_si256();
+
+            for(std::uint32_t ty = band; ty < band_end; ty += 4) {
+                __m256i l, h, t;
+                if(ty + 4 <= band_end) {
+                    l = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(low + ty));
+                    h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(high + ty));
+                    t = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + ty));
+                }
+                else {
+                    // Only load the rows that are left
+                    const __m256i tail = _mm256_cmpgt_epi64(_mm256_set1_epi64x(band_end - ty), lane);
+                    l = _mm256_maskload_epi64(low + ty, tail);
+                    h = _mm256_maskload_epi64(high + ty, tail);
+                    t = _mm256_maskload_epi64(text + ty, tail);
+                }
+                __m256i pixels = _mm256_or_si256(_mm256_srl_epi64(l, shift_right), _mm256_sll_epi64(h, shift_left));
+                band_misses = _mm256_add_epi64(band_misses, popcount_epi64(_mm256_and_si256(_mm256_xor_si256(pixels, t), mask)));
+            }
+
+            __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(band_misses), _mm256_extracti128_si256(band_misses, 1));
+            misses += static_cast<std::uint32_t>(_mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum)));
+            rows_compared += band_end - band;
+            if(misses > miss_limit) {
+                return misses;
+            }
+        }
+
+        image_column += image_height;
+        text_column += text_height;
+    }
+
+    return misses;
+}
@@ -0,0 +1,51 @@
+#include <immintrin.h>
+
+#include "match_kernel.hpp"
+
+static_assert(MATCH_KERNEL_BAND == 8, "the AVX-512 kernel handles a band as one vector of eight rows");
+
+// Count the set bits of each 64-bit lane with a nibble lookup table
+static inline __m512i popcount_epi64(__m512i v) {
+    const __m512i table = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+    const __m512i nibble = _mm512_set1_epi8(0x0F);
+    __m512i low = _mm512_shuffle_epi8(table, _mm512_and_si512(v, nibble));
+    __m512i high = _mm512_shuffle_epi8(table, _mm512_and_si512(_mm512_srli_epi16(v, 4), nibble));
+    return _mm512_sad_epu8(_mm512_add_epi8(low, high), _mm512_setzero_si512());
+}
+
+std::uint32_t count_misses_avx512bw(const std::uint64_t *image_column, std::uint32_t image_height, const std::uint64_t *text_column, std::uint32_t text_height, std::uint32_t text_columns, std::uint64_t last_column_mask, std::uint32_t shift, std::uint32_t miss_limit, std::uint32_t &rows_compared) {
+    // Shifting a lane left by 64 clears it, so shift == 0 needs no special case
+    const __m128i shift_right = _mm_cvtsi32_si128(static_cast<int>(shift));
+    const __m128i shift_left = _mm_cvtsi32_si128(static_cast<int>(64 - shift));
+    std::uint32_t misses = 0;
+    rows_compared = 0;
+
+    for(std::uint32_t column = 0; column < text_columns; column++) {
+        std::uint64_t mask_word = column + 1 == text_columns ? last_column_mask : ~std::uint64_t(0);
+        const __m512i mask = _mm512_set1_epi64(static_cast<long long>(mask_word));
+        const auto *low = image_column;
+        const auto *high = image_column + image_height;
+
+        for(std::uint32_t band = 0; band < text_height; band += MATCH_KERNEL_BAND) {
+            std::uint32_t rows = text_height - band < MATCH_KERNEL_BAND ? text_height - band : MATCH_KERNEL_BAND;
+
+            // Only load the rows that are left
+            const __mmask8 load = static_cast<__mmask8>((1U << rows) - 1);
+            __m512i l = _mm512_maskz_loadu_epi64(load, low + band);
+            __m512i h = _mm512_maskz_loadu_epi64(load, high + band);
+            __m512i t = _mm512_maskz_loadu_epi64(load, text_column + band);
+            __m512i pixels = _mm512_or_si512(_mm512_srl_epi64(l, shift_right), _mm512_sll_epi64(h, shift_left));
+
+            misses += static_cast<std::uint32_t>(_mm512_reduce_add_epi64(popcount_epi64(_mm512_and_si512(_mm512_xor_si512(pixels, t), mask))));
+            rows_compared += rows;
+            if(misses > miss_limit) {
+                return misses;
+            }
+        }
+
+        image_column += image_height;
+        text_column += text_height;
+    }
+
+    return misses;
+}
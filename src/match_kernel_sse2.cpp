@@ -0,0 +1,63 @@
+#include <emmintrin.h>
+
+#include "match_kernel.hpp"
+
+// Count the set bits of each 64-bit lane
+static inline __m128i popcount_epi64(__m128i v) {
+    const __m128i m1 = _mm_set1_epi8(0x55);
+    const __m128i m2 = _mm_set1_epi8(0x33);
+    const __m128i m4 = _mm_set1_epi8(0x0F);
+    v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi16(v, 1), m1));
+    v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+    v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+    return _mm_sad_epu8(v, _mm_setzero_si128());
+}
+
+std::uint32_t count_misses_sse2(const std::uint64_t *image_column, std::uint32_t image_height, const std::uint64_t *text_column, std::uint32_t text_height, std::uint32_t text_columns, std::uint64_t last_column_mask, std::uint32_t shift, std::uint32_t miss_limit, std::uint32_t &rows_compared) {
+    // Shifting a lane left by 64 clears it, so shift == 0 needs no special case
+    const __m128i shift_right = _mm_cvtsi32_si128(static_cast<int>(shift));
+    const __m128i shift_left = _mm_cvtsi32_si128(static_cast<int>(64 - shift));
+    std::uint32_t misses = 0;
+    rows_compared = 0;
+
+    for(std::uint32_t column = 0; column < text_columns; column++) {
+        std::uint64_t mask_word = column + 1 == text_columns ? last_column_mask : ~std::uint64_t(0);
+        const __m128i mask = _mm_set1_epi64x(static_cast<long long>(mask_word));
+        const auto *low = image_column;
+        const auto *high = image_column + image_height;
+
+        for(std::uint32_t band = 0; band < text_height; band += MATCH_KERNEL_BAND) {
+            std::uint32_t band_end = band + MATCH_KERNEL_BAND < text_height ? band + MATCH_KERNEL_BAND : text_height;
+            __m128i band_misses = _mm_setzero_si128();
+
+            std::uint32_t ty = band;
+            for(; ty + 2 <= band_end; ty += 2) {
+                __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i *>(low + ty));
+                __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(high + ty));
+                __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text_column + ty));
+                __m128i pixels = _mm_or_si128(_mm_srl_epi64(l, shift_right), _mm_sll_epi64(h, shift_left));
+                band_misses = _mm_add_epi64(band_misses, popcount_epi64(_mm_and_si128(_mm_xor_si128(pixels, t), mask)));
+            }
+
+            // Odd row out goes in the low lane with the high lane zeroed
+            if(ty < band_end) {
+                __m128i l = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(low + ty));
+                __m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(high + ty));
+                __m128i t = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(text_column + ty));
+                __m128i pixels = _mm_or_si128(_mm_srl_epi64(l, shift_right), _mm_sll_epi64(h, shift_left));
+                band_misses = _mm_add_epi64(band_misses, popcount_epi64(_mm_and_si128(_mm_xor_si128(pixels, t), mask)));
+            }
+
+            misses += static_cast<std::uint32_t>(_mm_cvtsi128_si32(band_misses) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(band_misses, band_misses)));
+            rows_compared += band_end - band;
+            if(misses > miss_limit) {
+                return misses;
+            }
+        }
+
+        image_column += image_height;
+        text_column += text_height;
+    }
+
+    return misses;
+}
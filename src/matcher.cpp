@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cmath>
+
+#include "matcher.hpp"
+#include "correlation.hpp"
+
+/** Templates are only searched for at levels where they are at least this many pixels wide and tall */
+static constexpr std::uint32_t MINIMUM_COARSE_SIZE = 6;
+
+/** Number of candidates kept from the coarsest level */
+static constexpr std::size_t COARSE_CANDIDATES = 4;
+
+/** Each candidate is refined within this many pixels of where it lands on the next finer level */
+static constexpr std::uint32_t REFINE_RADIUS = 2;
+
+PyramidTemplate::PyramidTemplate(BitImage text) : text(std::move(text)) {
+    const auto *previous = &this->text;
+    for(std::size_t l = 0; l < PYRAMID_LEVELS; l++) {
+        previous = &this->levels.emplace_back(downsample(*previous));
+    }
+}
+
+Matcher::Matcher(const BitImage &image, std::pmr::memory_resource *resource) : image(image), resource(resource), sums(resource), pyramid(resource) {
+    std::size_t stride = image.width + 1;
+    this->sums.resize(stride * (image.height + 1));
+
+    for(std::uint32_t y = 0; y < image.height; y++) {
+        const auto *above = this->sums.data() + static_cast<std::size_t>(y) * stride;
+        auto *row = this->sums.data() + static_cast<std::size_t>(y + 1) * stride;
+        std::uint32_t row_sum = 0;
+        for(std::uint32_t x = 0; x < image.width; x++) {
+            row_sum += image.get(x, y);
+            row[x + 1] = above[x + 1] + row_sum;
+        }
+    }
+
+    // Make room for every level at once
+    this->pyramid.reserve(PYRAMID_LEVELS);
+    const auto *previous = &image;
+    for(std::size_t l = 0; l < PYRAMID_LEVELS; l++) {
+        previous = &this->pyramid.emplace_back(downsample(*previous, 1, this->resource));
+    }
+}
+
+float Matcher::match_bounded(const BitView &text, std::uint32_t x, std::uint32_t y, float score_to_beat) const {
+    std::uint32_t pixels_compared;
+    float score = ::match_bounded(this->image, text, x, y, score_to_beat, pixels_compared);
+
+    if(this->fits(text, x, y)) {
+        std::uint32_t total = text.width * text.height;
+        this->statistics.matches++;
+        this->statistics.pixels_compared += pixels_compared;
+        if(pixels_compared < total) {
+            this->statistics.early_exits++;
+            this->statistics.pixels_skipped += total - pixels_compared;
+        }
+    }
+
+    return score;
+}
+
+float Matcher::upper_bound(const BitView &text, std::uint32_t x, std::uint32_t y) const {
+    if(!this->fits(text, x, y)) {
+        return 0.0F;
+    }
+
+    std::uint32_t total = text.height * text.width;
+    std::uint32_t window_ink = this->ink(x, y, text.width, text.height);
+    std::uint32_t difference = window_ink > text.ink ? window_ink - text.ink : text.ink - window_ink;
+
+    return static_cast<float>(total - difference) / total;
+}
+
+std::optional<MatchPosition> Matcher::coarse_search(const PyramidTemplate &text, std::uint32_t min_x, std::uint32_t min_y, std::uint32_t max_x, std::uint32_t max_y) const {
+    // Start at the lowest resolution the template is still recognizable at
+    std::size_t level = PYRAMID_LEVELS;
+    while(level > 0 && (text.levels[level - 1].width < MINIMUM_COARSE_SIZE || text.levels[level - 1].height < MINIMUM_COARSE_SIZE)) {
+        level--;
+    }
+    if(level == 0 || min_x >= max_x || min_y >= max_y) {
+        return std::nullopt;
+    }
+
+    auto image_at = [this](std::size_t level) -> const BitImage & {
+        return level == 0 ? this->image : this->pyramid[level - 1];
+    };
+    auto text_at = [&text](std::size_t level) -> const BitImage & {
+        return level == 0 ? text.text : text.levels[level - 1];
+    };
+
+    // Keep the best few positions at the coarsest level, best first
+    std::pmr::vector<MatchPosition> candidates(this->resource);
+    candidates.reserve(COARSE_CANDIDATES + 1);
+    std::uint32_t coarse_max_x = (max_x + (1 << level) - 1) >> level;
+    std::uint32_t coarse_max_y = (max_y + (1 << level) - 1) >> level;
+    for(std::uint32_t y = min_y >> level; y < coarse_max_y; y++) {
+        for(std::uint32_t x = min_x >> level; x < coarse_max_x; x++) {
+            float score = ::match(image_at(level), text_at(level), x, y);
+            if(candidates.size() == COARSE_CANDIDATES && score <= candidates.back().score) {
+                continue;
+            }
+            auto insert_at = std::upper_bound(candidates.begin(), candidates.end(), score, [](float score, const MatchPosition &candidate) {
+                return score > candidate.score;
+            });
+            candidates.insert(insert_at, MatchPosition { x, y, score });
+            if(candidates.size() > COARSE_CANDIDATES) {
+                candidates.pop_back();
+            }
+        }
+    }
+
+    // Follow each candidate down to full size, only looking near where it should be on each finer level
+    while(level > 0) {
+        level--;
+        std::uint32_t level_min_x = min_x >> level;
+        std::uint32_t level_min_y = min_y >> level;
+        std::uint32_t level_max_x = (max_x + (1 << level) - 1) >> level;
+        std::uint32_t level_max_y = (max_y + (1 << level) - 1) >> level;
+
+        for(auto &candidate : candidates) {
+            std::uint32_t center_x = candidate.x * 2;
+            std::uint32_t center_y = candidate.y * 2;
+            MatchPosition best = { center_x, center_y, -1.0F };
+
+            std::uint32_t from_x = std::max(level_min_x, center_x > REFINE_RADIUS ? center_x - REFINE_RADIUS : 0);
+            std::uint32_t from_y = std::max(level_min_y, center_y > REFINE_RADIUS ? center_y - REFINE_RADIUS : 0);
+            std::uint32_t to_x = std::min(level_max_x, center_x + REFINE_RADIUS + 1);
+            std::uint32_t to_y = std::min(level_max_y, center_y + REFINE_RADIUS + 1);
+
+            for(std::uint32_t y = from_y; y < to_y; y++) {
+                for(std::uint32_t x = from_x; x < to_x; x++) {
+                    float score = ::match(image_at(level), text_at(level), x, y);
+                    if(score > best.score) {
+                        best = { x, y, score };
+                    }
+                }
+            }
+
+            candidate = best;
+        }
+    }
+
+    return *std::max_element(candidates.begin(), candidates.end(), [](const MatchPosition &a, const MatchPosition &b) {
+        return a.score < b.score;
+    });
+}
+
+MatchPosition Matcher::find_best(const PyramidTemplate &text, std::uint32_t min_x, std::uint32_t min_y, std::uint32_t max_x, std::uint32_t max_y, float minimum) const {
+    const auto &text_drawn = text.text;
+
+    // Get a rough idea of where the template is from a low resolution search. Whatever it scores at full size, the
+    // best window has to score at least that, so any window whose bound is lower is skipped below.
+    float seed_percent = 0.0F;
+    auto seed = this->coarse_search(text, min_x, min_y, max_x, max_y);
+    if(seed.has_value()) {
+        seed_percent = seed->score;
+    }
+
+    // Long templates are cheaper to score everywhere at once in the frequency domain
+    auto scores = this->correlate(text_drawn, min_x, min_y, max_x, max_y);
+
+    MatchPosition found = { min_x, min_y, 0.0F };
+
+    // Windows that can't reach the minimum are only worth matching if we need to say how close we got
+    auto search = [&](bool require_minimum) {
+        for(std::uint32_t y = min_y; y < max_y; y++) {
+            for(std::uint32_t x = min_x; x < max_x; x++) {
+                float bound = this->upper_bound(text_drawn, x, y);
+                if(bound <= found.score || bound < seed_percent || (require_minimum && bound < minimum)) {
+                    continue;
+                }
+
+                // Only a score that would replace the best so far matters
+                float score_to_beat = std::max(found.score, std::nextafter(seed_percent, 0.0F));
+                if(require_minimum) {
+                    score_to_beat = std::max(score_to_beat, std::nextafter(minimum, 0.0F));
+                }
+
+                float score = scores.has_value() ? scores->at(x, y) : this->match_bounded(text_drawn, x, y, score_to_beat);
+                if(score > found.score) {
+                    found = { x, y, score };
+                }
+            }
+        }
+    };
+
+    search(true);
+    if(found.score < minimum) {
+        found = { min_x, min_y, 0.0F };
+        search(false);
+    }
+
+    return found;
+}
+
+std::optional<ScoreMap> Matcher::correlate(const BitView &text, std::uint32_t min_x, std::uint32_t min_y, std::uint32_t max_x, std::uint32_t max_y) const {
+    if(min_x >= max_x || min_y >= max_y || !correlation_is_cheaper(text, min_x, min_y, max_x, max_y)) {
+        return std::nullopt;
+    }
+
+    auto overlap = ::correlate(this->image, text, min_x, min_y, max_x, max_y, this->resource);
+
+    ScoreMap map { min_x, min_y, max_x - min_x, std::pmr::vector<float>(overlap.size(), this->resource) };
+
+    // Pixels match where both are set or both are clear, so hits = total - (text ink - overlap) - (window ink - overlap)
+    std::uint32_t total = text.width * text.height;
+    for(std::uint32_t y = min_y; y < max_y; y++) {
+        for(std::uint32_t x = min_x; x < max_x; x++) {
+            if(!this->fits(text, x, y)) {
+                continue;
+            }
+            std::size_t i = (x - min_x) + (y - min_y) * map.width;
+            std::uint32_t hits = total + 2 * overlap[i] - text.ink - this->ink(x, y, text.width, text.height);
+            map.scores[i] = static_cast<float>(hits) / total;
+        }
+    }
+
+    return map;
+}
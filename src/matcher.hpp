@@ -0,0 +1,237 @@
+#ifndef CARNAGE_REPORTER__MATCHER_HPP
+#define CARNAGE_REPORTER__MATCHER_HPP
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+#include "bit_image.hpp"
+
+/**
+ * Number of downsampled levels kept for coarse-to-fine searches, each half the size of the one before it
+ */
+static constexpr std::size_t PYRAMID_LEVELS = 2;
+
+/**
+ * A template along with downsampled copies of it for coarse-to-fine searches
+ */
+struct PyramidTemplate {
+    /** Full size template */
+    BitImage text;
+
+    /** Downsampled templates, starting at half size */
+    std::vector<BitImage> levels;
+
+    /**
+     * Build the downsampled levels of a template
+     * @param text full size template
+     */
+    PyramidTemplate(BitImage text);
+};
+
+/**
+ * Where a template was found and how well it matched there
+ */
+struct MatchPosition {
+    std::uint32_t x;
+    std::uint32_t y;
+    float score;
+};
+
+/**
+ * Scores of a template at every position in a rectangle
+ */
+struct ScoreMap {
+    std::uint32_t min_x;
+    std::uint32_t min_y;
+    std::uint32_t width;
+    std::pmr::vector<float> scores;
+
+    /**
+     * Get the score at a position
+     * @param x x coordinate; must be in the rectangle
+     * @param y y coordinate; must be in the rectangle
+     * @return  score
+     */
+    float at(std::uint32_t x, std::uint32_t y) const {
+        return this->scores[(x - this->min_x) + (y - this->min_y) * this->width];
+    }
+};
+
+/**
+ * Counts of how much pixel by pixel matching was done and how much was avoided by stopping early
+ */
+struct MatchStatistics {
+    /** Windows that were matched pixel by pixel, including ones given up on before any pixels were compared */
+    std::uint64_t matches = 0;
+
+    /** Windows that were given up on once they could no longer beat the score they needed to */
+    std::uint64_t early_exits = 0;
+
+    /** Pixels compared */
+    std::uint64_t pixels_compared = 0;
+
+    /** Pixels that did not need to be compared because their window was given up on */
+    std::uint64_t pixels_skipped = 0;
+
+    /**
+     * Add another set of statistics to this one
+     * @param other statistics to add
+     */
+    void add(const MatchStatistics &other) {
+        this->matches += other.matches;
+        this->early_exits += other.early_exits;
+        this->pixels_compared += other.pixels_compared;
+        this->pixels_skipped += other.pixels_skipped;
+    }
+};
+
+/**
+ * Matches templates against a screenshot. Along with the packed screenshot, this keeps a summed-area table of its set
+ * pixels so a window can be ruled out in constant time before any pixels are compared, and downsampled copies of the
+ * screenshot for coarse-to-fine searches.
+ */
+class Matcher {
+public:
+    /**
+     * Find how well a template matches the image at a given position
+     * @param text template to match
+     * @param x    left of the template in the image
+     * @param y    top of the template in the image
+     * @return     fraction of pixels that match, or 0 if the template does not fit
+     */
+    float match(const BitView &text, std::uint32_t x, std::uint32_t y) const {
+        return this->match_bounded(text, x, y, -1.0F);
+    }
+
+    /**
+     * Find how well a template matches the image at a given position, giving up as soon as the pixels left to compare
+     * can't bring it above a score. Searches that only want something better than their best so far pass that here.
+     * @param text          template to match
+     * @param x             left of the template in the image
+     * @param y             top of the template in the image
+     * @param score_to_beat score the match has to be greater than to be useful (negative to always finish)
+     * @return              same as match() if that is greater than score_to_beat; otherwise some score that is not
+     */
+    float match_bounded(const BitView &text, std::uint32_t x, std::uint32_t y, float score_to_beat) const;
+
+    /**
+     * Get the best score match() could return for a template at a given position. A window with a ink pixels can't
+     * match a template with b ink pixels on more than total - |a - b| pixels. This is never less than what match()
+     * returns, so any window whose bound does not beat a score can be skipped.
+     * @param text template to match
+     * @param x    left of the template in the image
+     * @param y    top of the template in the image
+     * @return     upper bound of the score, or 0 if the template does not fit
+     */
+    float upper_bound(const BitView &text, std::uint32_t x, std::uint32_t y) const;
+
+    /**
+     * Score a template at every position in a rectangle at once by correlating it with the image in the frequency
+     * domain, if that is estimated to be cheaper than matching each position directly. The set pixels are correlated
+     * with the FFT and the background pixels come from the summed-area table, so the scores are exactly what match()
+     * returns. The scores are allocated from the matcher's memory resource.
+     * @param text  template to search for
+     * @param min_x leftmost position
+     * @param min_y topmost position
+     * @param max_x rightmost position (exclusive)
+     * @param max_y bottommost position (exclusive)
+     * @return      scores, or std::nullopt if matching directly is cheaper
+     */
+    std::optional<ScoreMap> correlate(const BitView &text, std::uint32_t min_x, std::uint32_t min_y, std::uint32_t max_x, std::uint32_t max_y) const;
+
+    /**
+     * Find a good position for a template by searching a downsampled level, then refining the best few candidates in
+     * small neighborhoods at each finer level. This is not guaranteed to find the best position, but the score is a
+     * real full size score, so an exhaustive search can skip every window whose upper bound is less than it.
+     * @param text  template to search for
+     * @param min_x leftmost position to search
+     * @param min_y topmost position to search
+     * @param max_x rightmost position to search (exclusive)
+     * @param max_y bottommost position to search (exclusive)
+     * @return      position found, or std::nullopt if the template is too small to search for at a lower resolution
+     */
+    std::optional<MatchPosition> coarse_search(const PyramidTemplate &text, std::uint32_t min_x, std::uint32_t min_y, std::uint32_t max_x, std::uint32_t max_y) const;
+
+    /**
+     * Find the position in a rectangle where a template matches best, the first one in row order if several tie. A
+     * coarse search gives a score to skip windows by, and long templates are correlated in the frequency domain, but
+     * the result is the same as calling match() everywhere. Windows that can't reach the minimum are only matched if
+     * none does.
+     * @param text    template to search for
+     * @param min_x   leftmost position to search
+     * @param min_y   topmost position to search
+     * @param max_x   rightmost position to search (exclusive)
+     * @param max_y   bottommost position to search (exclusive)
+     * @param minimum score the template has to match with to be found
+     * @return        best position, which scored less than minimum if the template wasn't found
+     */
+    MatchPosition find_best(const PyramidTemplate &text, std::uint32_t min_x, std::uint32_t min_y, std::uint32_t max_x, std::uint32_t max_y, float minimum) const;
+
+    /**
+     * Count the set pixels in a rectangle
+     * @param x      left of the rectangle
+     * @param y      top of the rectangle
+     * @param width  width of the rectangle
+     * @param height height of the rectangle
+     * @return       number of set pixels
+     */
+    std::uint32_t ink(std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height) const {
+        std::size_t stride = this->image.width + 1;
+        const auto *top = this->sums.data() + static_cast<std::size_t>(y) * stride;
+        const auto *bottom = top + static_cast<std::size_t>(height) * stride;
+        return bottom[x + width] - bottom[x] - top[x + width] + top[x];
+    }
+
+    /**
+     * Get whether or not a template fits in the image at a given position
+     * @param text template
+     * @param x    left of the template in the image
+     * @param y    top of the template in the image
+     * @return     true if it fits and isn't empty
+     */
+    bool fits(const BitView &text, std::uint32_t x, std::uint32_t y) const {
+        const auto &image = this->image;
+        return x <= image.width && text.width <= image.width - x && y <= image.height && text.height <= image.height - y && text.width != 0 && text.height != 0;
+    }
+
+    /**
+     * Get how much matching this matcher has done
+     * @return statistics
+     */
+    const MatchStatistics &get_statistics() const {
+        return this->statistics;
+    }
+
+    /**
+     * Get the image being matched against
+     * @return image
+     */
+    const BitImage &get_image() const {
+        return this->image;
+    }
+
+    /**
+     * Build the summed-area table for an image
+     * @param image    image to match against; must outlive the matcher and have at least one padding column
+     * @param resource where to allocate the table, the downsampled images, and anything made while matching; must
+     *                 outlive the matcher
+     */
+    Matcher(const BitImage &image, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+private:
+    const BitImage &image;
+    std::pmr::memory_resource *resource;
+
+    /** Number of set pixels above and to the left of each pixel; (width + 1) * (height + 1) entries */
+    std::pmr::vector<std::uint32_t> sums;
+
+    /** Downsampled images, starting at half size */
+    std::pmr::vector<BitImage> pyramid;
+
+    /** Matching done so far; a matcher is only used by one thread at a time */
+    mutable MatchStatistics statistics;
+};
+
+#endif
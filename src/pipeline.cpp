@@ -0,0 +1,131 @@
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "pipeline.hpp"
+#include "bounded_queue.hpp"
+
+namespace {
+    /** Pool blocks up to this size, which covers a decoded 480p image and stb_image's buffers for decoding it */
+    constexpr std::size_t LARGEST_POOLED_BLOCK = 4 * 1024 * 1024;
+
+    /** How many items each queue holds for every thread taking from it */
+    constexpr std::size_t QUEUE_DEPTH_PER_THREAD = 2;
+
+    struct Decoded {
+        std::size_t image;
+        DecodedImage decoded;
+    };
+
+    struct Binarized {
+        std::size_t image;
+        Screenshot screenshot;
+    };
+}
+
+PipelineStatistics run_pipeline(const std::vector<std::string> &paths, const PipelineThreads &threads, const std::function<void (std::size_t image, const CarnageError &error)> &failed, const std::function<void (std::size_t image, const Screenshot &screenshot, std::size_t thread)> &read) {
+    PipelineThreads counts = { std::max<std::size_t>(threads.decode, 1), std::max<std::size_t>(threads.binarize, 1), std::max<std::size_t>(threads.read, 1) };
+
+    // Images are allocated on one thread and freed on the next, so they come from a shared pool rather than each
+    // thread's arena; once the pool has grown to fit the images in flight, it stops allocating
+    std::pmr::pool_options options;
+    options.largest_required_pool_block = LARGEST_POOLED_BLOCK;
+    std::pmr::synchronized_pool_resource pool(options);
+
+    BoundedQueue<Decoded> decoded(counts.binarize * QUEUE_DEPTH_PER_THREAD);
+    BoundedQueue<Binarized> binarized(counts.read * QUEUE_DEPTH_PER_THREAD);
+
+    PipelineStatistics statistics = { { { "decode", counts.decode, 0.0 }, { "binarize", counts.binarize, 0.0 }, { "read", counts.read, 0.0 } }, 0.0 };
+    std::mutex statistics_mutex;
+    auto add_busy = [&statistics, &statistics_mutex](StageStatistics &stage, std::chrono::steady_clock::duration busy) {
+        std::lock_guard<std::mutex> lock(statistics_mutex);
+        stage.busy_seconds += std::chrono::duration<double>(busy).count();
+    };
+
+    // The last thread out of each stage tells the next stage nothing more is coming
+    std::atomic<std::size_t> next_image = 0;
+    std::atomic<std::size_t> decoders_left = counts.decode;
+    std::atomic<std::size_t> binarizers_left = counts.binarize;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> stage_threads;
+
+    for(std::size_t t = 0; t < counts.decode; t++) {
+        stage_threads.emplace_back([&]() {
+            std::chrono::steady_clock::duration busy {};
+            std::size_t image;
+            while((image = next_image++) < paths.size()) {
+                auto before = std::chrono::steady_clock::now();
+                std::optional<DecodedImage> image_decoded;
+                try {
+                    image_decoded.emplace(DecodedImage::load(paths[image].data(), &pool));
+                }
+                catch(CarnageError &e) {
+                    failed(image, e);
+                }
+                catch(std::exception &e) {
+                    failed(image, make_read_error(e));
+                }
+                busy += std::chrono::steady_clock::now() - before;
+
+                if(image_decoded.has_value()) {
+                    decoded.push(Decoded { image, std::move(*image_decoded) });
+                }
+            }
+            add_busy(statistics.stages[0], busy);
+            if(--decoders_left == 0) {
+                decoded.close();
+            }
+        });
+    }
+
+    for(std::size_t t = 0; t < counts.binarize; t++) {
+        stage_threads.emplace_back([&]() {
+            std::chrono::steady_clock::duration busy {};
+            while(auto item = decoded.pop()) {
+                auto before = std::chrono::steady_clock::now();
+                auto image = item->image;
+                std::optional<Screenshot> screenshot;
+                try {
+                    screenshot.emplace(make_screenshot(item->decoded, &pool));
+                }
+                catch(std::exception &e) {
+                    failed(image, make_read_error(e));
+                }
+                item.reset();
+                busy += std::chrono::steady_clock::now() - before;
+
+                if(screenshot.has_value()) {
+                    binarized.push(Binarized { image, std::move(*screenshot) });
+                }
+            }
+            add_busy(statistics.stages[1], busy);
+            if(--binarizers_left == 0) {
+                binarized.close();
+            }
+        });
+    }
+
+    for(std::size_t t = 0; t < counts.read; t++) {
+        stage_threads.emplace_back([&, t]() {
+            std::chrono::steady_clock::duration busy {};
+            while(auto item = binarized.pop()) {
+                auto before = std::chrono::steady_clock::now();
+                read(item->image, item->screenshot, t);
+                item.reset();
+                busy += std::chrono::steady_clock::now() - before;
+            }
+            add_busy(statistics.stages[2], busy);
+        });
+    }
+
+    for(auto &thread : stage_threads) {
+        thread.join();
+    }
+    statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return statistics;
+}
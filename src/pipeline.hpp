@@ -0,0 +1,58 @@
+#ifndef CARNAGE_REPORTER__PIPELINE_HPP
+#define CARNAGE_REPORTER__PIPELINE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "error.hpp"
+#include "screenshot.hpp"
+
+/**
+ * Number of threads in each stage of a pipeline
+ */
+struct PipelineThreads {
+    /** Threads decoding image files, which is mostly bound by memory */
+    std::size_t decode;
+
+    /** Threads reducing decoded images to bit planes */
+    std::size_t binarize;
+
+    /** Threads reading the bit planes, which is mostly bound by computation */
+    std::size_t read;
+};
+
+/**
+ * How busy one stage of a pipeline was
+ */
+struct StageStatistics {
+    const char *name;
+    std::size_t threads;
+
+    /** Total time the stage's threads spent working rather than waiting for each other, in seconds */
+    double busy_seconds;
+};
+
+/**
+ * How a pipeline went
+ */
+struct PipelineStatistics {
+    StageStatistics stages[3];
+
+    /** Time from starting the pipeline to the last image being read, in seconds */
+    double seconds;
+};
+
+/**
+ * Read images through three stages that each have their own pool of threads (decoding, binarizing, and reading),
+ * connected by bounded lock-free queues, so each kind of work can be given as many threads as it needs
+ * @param paths   image files to read
+ * @param threads number of threads in each stage
+ * @param failed  called on a decoding or binarizing thread with the index of each image that couldn't be decoded, and why
+ * @param read    called on a reading thread with the index of each image, its screenshot, and the reading thread's index
+ * @return        statistics
+ */
+PipelineStatistics run_pipeline(const std::vector<std::string> &paths, const PipelineThreads &threads, const std::function<void (std::size_t image, const CarnageError &error)> &failed, const std::function<void (std::size_t image, const Screenshot &screenshot, std::size_t thread)> &read);
+
+#endif
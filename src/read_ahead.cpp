@@ -0,0 +1,579 @@
+#include <atomic>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// io_uring is used through its system calls directly, so nothing beyond the kernel headers is needed to build it
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define CARNAGE_REPORTER_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "read_ahead.hpp"
+#include "job_queue.hpp"
+
+namespace {
+    /**
+     * Files that are being read or waiting for a worker; no more than depth at once, so memory doesn't grow with the
+     * number of files
+     */
+    class ReadSlots {
+    public:
+        /**
+         * Wait until another file can be read
+         */
+        void acquire() {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->released.wait(lock, [this]() {
+                return this->used < this->depth;
+            });
+            this->used++;
+        }
+
+        /**
+         * Start another file if there's room
+         * @return true if there was
+         */
+        bool try_acquire() {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if(this->used >= this->depth) {
+                return false;
+            }
+            this->used++;
+            return true;
+        }
+
+        /**
+         * A worker took a file
+         */
+        void release() {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->used--;
+            }
+            this->released.notify_one();
+        }
+
+        ReadSlots(std::size_t depth) : depth(depth) {}
+
+    private:
+        std::mutex mutex;
+        std::condition_variable released;
+        std::size_t used = 0;
+        std::size_t depth;
+    };
+
+    /**
+     * Read a whole file with blocking reads
+     * @param path     path to the file
+     * @param contents set to the contents, or the error
+     */
+    void read_file(const char *path, FileContents &contents) {
+        #ifdef _WIN32
+        std::FILE *f = std::fopen(path, "rb");
+        if(!f) {
+            contents.error = errno;
+            return;
+        }
+        std::byte buffer[65536];
+        std::size_t read;
+        while((read = std::fread(buffer, 1, sizeof(buffer), f)) > 0) {
+            contents.data.insert(contents.data.end(), buffer, buffer + read);
+        }
+        if(std::ferror(f)) {
+            contents.error = EIO;
+        }
+        std::fclose(f);
+        #else
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        struct stat file_stat;
+        if(fd == -1 || fstat(fd, &file_stat) == -1) {
+            contents.error = errno;
+            if(fd != -1) {
+                close(fd);
+            }
+            return;
+        }
+
+        contents.data.resize(static_cast<std::size_t>(file_stat.st_size));
+        std::size_t done = 0;
+        while(done < contents.data.size()) {
+            auto read = pread(fd, contents.data.data() + done, contents.data.size() - done, static_cast<off_t>(done));
+            if(read == -1 && errno == EINTR) {
+                continue;
+            }
+            if(read == -1) {
+                contents.error = errno;
+                break;
+            }
+            if(read == 0) {
+                contents.data.resize(done);
+                break;
+            }
+            done += static_cast<std::size_t>(read);
+        }
+        close(fd);
+        #endif
+    }
+
+    /**
+     * Read files on a pool of threads, each blocking on one file at a time
+     * @param files indices of the paths to read
+     */
+    void read_with_threads(const std::vector<std::string> &paths, const std::vector<std::size_t> &files, std::size_t depth, ReadSlots &slots, JobQueue<FileContents> &queue) {
+        std::atomic<std::size_t> next_file = 0;
+        std::vector<std::thread> threads;
+        for(std::size_t t = 0; t < std::min(depth, files.size()); t++) {
+            threads.emplace_back([&]() {
+                std::size_t next;
+                while((next = next_file++) < files.size()) {
+                    slots.acquire();
+                    FileContents contents { files[next], {}, 0 };
+                    read_file(paths[files[next]].data(), contents);
+                    queue.push(std::move(contents));
+                }
+            });
+        }
+        for(auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    #ifdef CARNAGE_REPORTER_IO_URING
+    /** Most files io_uring reads at once, which keeps the ring within what the kernel allows */
+    constexpr std::size_t MAX_IO_URING_DEPTH = 2048;
+
+    /**
+     * A submission and completion queue shared with the kernel
+     */
+    class IoUring {
+    public:
+        /**
+         * Set up a ring, if the kernel allows it and supports everything needed to read a file by path
+         * @param entries number of submissions that can be queued at once
+         * @return        true if it was set up
+         */
+        bool open(unsigned entries) {
+            io_uring_params params = {};
+            this->fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if(this->fd < 0) {
+                return false;
+            }
+
+            // Opening, checking the size, and reading all need to be supported
+            std::vector<std::byte> probe_buffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+            auto *probe = reinterpret_cast<io_uring_probe *>(probe_buffer.data());
+            if(syscall(__NR_io_uring_register, this->fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+                return false;
+            }
+            for(unsigned op : { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ }) {
+                if(op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                    return false;
+                }
+            }
+
+            this->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            this->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            if(params.features & IORING_FEAT_SINGLE_MMAP) {
+                this->sq_size = this->cq_size = std::max(this->sq_size, this->cq_size);
+            }
+            this->sq = mmap(nullptr, this->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQ_RING);
+            if(this->sq == MAP_FAILED) {
+                this->sq = nullptr;
+                return false;
+            }
+            if(params.features & IORING_FEAT_SINGLE_MMAP) {
+                this->cq = this->sq;
+            }
+            else {
+                this->cq = mmap(nullptr, this->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_CQ_RING);
+                if(this->cq == MAP_FAILED) {
+                    this->cq = nullptr;
+                    return false;
+                }
+            }
+            this->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            auto *sqes = mmap(nullptr, this->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQES);
+            if(sqes == MAP_FAILED) {
+                return false;
+            }
+            this->sqes = static_cast<io_uring_sqe *>(sqes);
+
+            auto *sq_ring = static_cast<std::byte *>(this->sq);
+            this->sq_tail = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.tail);
+            this->sq_mask = *reinterpret_cast<unsigned *>(sq_ring + params.sq_off.ring_mask);
+            this->sq_array = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.array);
+            this->next_tail = *this->sq_tail;
+
+            auto *cq_ring = static_cast<std::byte *>(this->cq);
+            this->cq_head = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.head);
+            this->cq_tail = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.tail);
+            this->cq_mask = *reinterpret_cast<unsigned *>(cq_ring + params.cq_off.ring_mask);
+            this->cqes = reinterpret_cast<io_uring_cqe *>(cq_ring + params.cq_off.cqes);
+            return true;
+        }
+
+        /**
+         * Queue a submission; it goes to the kernel on the next call to submit_and_wait()
+         * @param user_data value to get back with its completion
+         * @return          submission to fill in
+         */
+        io_uring_sqe &push(std::uint64_t user_data) {
+            unsigned index = this->next_tail++ & this->sq_mask;
+            auto &sqe = this->sqes[index];
+            sqe = {};
+            sqe.user_data = user_data;
+            this->sq_array[index] = index;
+            this->unsubmitted++;
+            return sqe;
+        }
+
+        /**
+         * Hand queued submissions to the kernel and wait for at least one completion
+         * @return 0, or an errno if the kernel couldn't be asked
+         */
+        int submit_and_wait() {
+            __atomic_store_n(this->sq_tail, this->next_tail, __ATOMIC_RELEASE);
+            while(true) {
+                auto result = syscall(__NR_io_uring_enter, this->fd, this->unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if(result >= 0) {
+                    this->unsubmitted -= static_cast<unsigned>(result);
+                    this->in_flight += static_cast<unsigned>(result);
+                    return 0;
+                }
+                if(errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                    return errno;
+                }
+            }
+        }
+
+        /**
+         * Wait for at least one completion without handing the kernel anything more. This works even after
+         * submit_and_wait() fails, so whatever the kernel already took can still be waited for.
+         * @return 0, or an errno if the kernel couldn't be asked
+         */
+        int wait() {
+            while(true) {
+                auto result = syscall(__NR_io_uring_enter, this->fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if(result >= 0) {
+                    return 0;
+                }
+                if(errno != EINTR && errno != EAGAIN && errno != EBUSY && errno != EBADR) {
+                    return errno;
+                }
+            }
+        }
+
+        /**
+         * Get how many submissions the kernel has taken that haven't completed yet
+         * @return number of submissions
+         */
+        unsigned get_in_flight() const {
+            return this->in_flight;
+        }
+
+        /**
+         * Handle every completion that has arrived
+         * @param handle called with each completion's user data and result
+         */
+        template<typename Handle> void complete(const Handle &handle) {
+            unsigned head = *this->cq_head;
+            unsigned tail = __atomic_load_n(this->cq_tail, __ATOMIC_ACQUIRE);
+            for(; head != tail; head++) {
+                const auto &cqe = this->cqes[head & this->cq_mask];
+                handle(cqe.user_data, cqe.res);
+                this->in_flight--;
+            }
+            __atomic_store_n(this->cq_head, head, __ATOMIC_RELEASE);
+        }
+
+        IoUring() = default;
+        IoUring(const IoUring &) = delete;
+        IoUring &operator=(const IoUring &) = delete;
+
+        ~IoUring() {
+            if(this->sqes) {
+                munmap(this->sqes, this->sqes_size);
+            }
+            if(this->cq && this->cq != this->sq) {
+                munmap(this->cq, this->cq_size);
+            }
+            if(this->sq) {
+                munmap(this->sq, this->sq_size);
+            }
+            if(this->fd >= 0) {
+                close(this->fd);
+            }
+        }
+
+    private:
+        int fd = -1;
+        void *sq = nullptr;
+        void *cq = nullptr;
+        std::size_t sq_size = 0;
+        std::size_t cq_size = 0;
+        std::size_t sqes_size = 0;
+        io_uring_sqe *sqes = nullptr;
+        unsigned *sq_tail = nullptr;
+        unsigned *sq_array = nullptr;
+        unsigned sq_mask = 0;
+
+        /** Where the next submission goes, and how many before it the kernel hasn't taken yet */
+        unsigned next_tail = 0;
+        unsigned unsubmitted = 0;
+
+        /** Submissions the kernel took that haven't completed */
+        unsigned in_flight = 0;
+        unsigned *cq_head = nullptr;
+        unsigned *cq_tail = nullptr;
+        unsigned cq_mask = 0;
+        io_uring_cqe *cqes = nullptr;
+    };
+
+    /**
+     * Read files with io_uring from this thread. Each file is opened and sized at once, then read in as few reads as the
+     * kernel allows, so no step blocks the thread.
+     * @param unread set to the files that still have to be read some other way, because the kernel stopped taking
+     *               submissions partway through
+     * @return       false if io_uring can't be used, in which case nothing was read
+     */
+    bool read_with_io_uring(const std::vector<std::string> &paths, std::size_t depth, ReadSlots &slots, JobQueue<FileContents> &queue, std::vector<std::size_t> &unread) {
+        // Each file has at most two submissions waiting at once
+        depth = std::min<std::size_t>({ depth, std::max<std::size_t>(paths.size(), 1), MAX_IO_URING_DEPTH });
+        IoUring ring;
+        if(!ring.open(static_cast<unsigned>(depth * 2))) {
+            return false;
+        }
+
+        struct Read {
+            std::size_t file;
+            int fd;
+            unsigned pending;
+            int error;
+            struct statx file_stat;
+            std::vector<std::byte> data;
+            std::size_t done;
+        };
+
+        // Submissions carry the read they belong to and what they are
+        enum : std::uint64_t {
+            OPEN,
+            STAT,
+            READ,
+            OPERATION_BITS = 2
+        };
+
+        std::vector<Read> reads(depth);
+        std::vector<std::size_t> free_reads;
+        for(std::size_t r = reads.size(); r > 0; r--) {
+            free_reads.push_back(r - 1);
+        }
+        std::size_t next_file = 0;
+        std::size_t active = 0;
+
+        auto finish = [&](std::size_t r) {
+            auto &read = reads[r];
+            if(read.fd >= 0) {
+                close(read.fd);
+            }
+            if(read.error) {
+                read.data.clear();
+            }
+            queue.push(FileContents { read.file, std::move(read.data), read.error });
+            free_reads.push_back(r);
+            active--;
+        };
+
+        auto submit_read = [&](std::size_t r) {
+            auto &read = reads[r];
+            auto &sqe = ring.push((r << OPERATION_BITS) | READ);
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = read.fd;
+            sqe.addr = reinterpret_cast<std::uintptr_t>(read.data.data() + read.done);
+            sqe.len = static_cast<std::uint32_t>(std::min<std::size_t>(read.data.size() - read.done, 1U << 30));
+            sqe.off = read.done;
+        };
+
+        while(next_file < paths.size() || active > 0) {
+            // Start on more files while there's room, and wait for room if nothing else is happening
+            while(next_file < paths.size() && !free_reads.empty() && (active > 0 ? slots.try_acquire() : (slots.acquire(), true))) {
+                auto r = free_reads.back();
+                free_reads.pop_back();
+                auto &read = reads[r];
+                read = Read { next_file, -1, 2, 0, {}, {}, 0 };
+                const char *path = paths[next_file].data();
+                next_file++;
+                active++;
+
+                auto &open = ring.push((r << OPERATION_BITS) | OPEN);
+                open.opcode = IORING_OP_OPENAT;
+                open.fd = AT_FDCWD;
+                open.addr = reinterpret_cast<std::uintptr_t>(path);
+                open.open_flags = O_RDONLY | O_CLOEXEC;
+
+                auto &stat = ring.push((r << OPERATION_BITS) | STAT);
+                stat.opcode = IORING_OP_STATX;
+                stat.fd = AT_FDCWD;
+                stat.addr = reinterpret_cast<std::uintptr_t>(path);
+                stat.len = STATX_SIZE;
+                stat.off = reinterpret_cast<std::uintptr_t>(&read.file_stat);
+            }
+
+            if(ring.submit_and_wait() != 0) {
+                // Whatever the kernel already took can still finish into the reads' buffers and file sizes, so wait for
+                // all of it before anything is freed. Nothing more is started, but files that are opened meanwhile still
+                // have to be closed.
+                while(ring.get_in_flight() > 0) {
+                    if(ring.wait() != 0) {
+                        // Nothing is being submitted to a ring that is ours, so this can't fail unless something here is
+                        // wrong, and freeing the buffers while the kernel may still write to them would be worse
+                        std::terminate();
+                    }
+                    ring.complete([&](std::uint64_t user_data, std::int32_t result) {
+                        auto &read = reads[static_cast<std::size_t>(user_data >> OPERATION_BITS)];
+                        if((user_data & ((1 << OPERATION_BITS) - 1)) == OPEN && result >= 0) {
+                            read.fd = result;
+                        }
+                    });
+                }
+
+                // The files that were being read and everything not started yet are read again without the ring, and
+                // their slots go to those reads
+                for(std::size_t r = 0; r < reads.size(); r++) {
+                    if(std::find(free_reads.begin(), free_reads.end(), r) == free_reads.end()) {
+                        if(reads[r].fd >= 0) {
+                            close(reads[r].fd);
+                        }
+                        unread.push_back(reads[r].file);
+                        slots.release();
+                    }
+                }
+                for(; next_file < paths.size(); next_file++) {
+                    unread.push_back(next_file);
+                }
+                return true;
+            }
+
+            ring.complete([&](std::uint64_t user_data, std::int32_t result) {
+                auto r = static_cast<std::size_t>(user_data >> OPERATION_BITS);
+                auto &read = reads[r];
+
+                auto operation = user_data & ((1 << OPERATION_BITS) - 1);
+                switch(operation) {
+                    case OPEN:
+                    case STAT:
+                        if(result < 0 && !read.error) {
+                            read.error = -result;
+                        }
+                        else if(operation == OPEN && result >= 0) {
+                            read.fd = result;
+                        }
+
+                        // Once it's open and its size is known, read all of it
+                        if(--read.pending == 0) {
+                            if(read.error || read.file_stat.stx_size == 0) {
+                                finish(r);
+                            }
+                            else {
+                                read.data.resize(static_cast<std::size_t>(read.file_stat.stx_size));
+                                submit_read(r);
+                            }
+                        }
+                        break;
+
+                    case READ:
+                        if(result == -EAGAIN || result == -EINTR) {
+                            submit_read(r);
+                        }
+                        else if(result < 0) {
+                            read.error = -result;
+                            finish(r);
+                        }
+                        else {
+                            // A file that shrank since it was sized just ends early
+                            read.done += static_cast<std::size_t>(result);
+                            if(result == 0) {
+                                read.data.resize(read.done);
+                            }
+                            if(read.done < read.data.size()) {
+                                submit_read(r);
+                            }
+                            else {
+                                finish(r);
+                            }
+                        }
+                        break;
+                }
+            });
+        }
+
+        return true;
+    }
+    #endif
+}
+
+ReadAheadStatistics read_ahead(const std::vector<std::string> &paths, std::size_t depth, std::size_t worker_count, const std::function<void (const FileContents &file, std::size_t worker)> &use) {
+    depth = std::max<std::size_t>(depth, 1);
+    ReadSlots slots(depth);
+    JobQueue<FileContents> queue;
+    ReadAheadStatistics statistics = { "threads", 0.0, 0.0 };
+
+    // Workers take files as they are read, keeping track of how long they go without one
+    std::mutex statistics_mutex;
+    std::vector<std::thread> workers;
+    for(std::size_t w = 0; w < std::max<std::size_t>(worker_count, 1); w++) {
+        workers.emplace_back([&, w]() {
+            auto start = std::chrono::steady_clock::now();
+            std::chrono::steady_clock::duration waited {};
+            while(true) {
+                auto before = std::chrono::steady_clock::now();
+                auto file = queue.pop();
+                waited += std::chrono::steady_clock::now() - before;
+                if(!file.has_value()) {
+                    break;
+                }
+                slots.release();
+                use(*file, w);
+            }
+
+            std::lock_guard<std::mutex> lock(statistics_mutex);
+            statistics.wait_seconds += std::chrono::duration<double>(waited).count();
+            statistics.worker_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        });
+    }
+
+    std::vector<std::size_t> unread;
+    #ifdef CARNAGE_REPORTER_IO_URING
+    if(read_with_io_uring(paths, depth, slots, queue, unread)) {
+        statistics.backend = unread.empty() ? "io_uring" : "io_uring, then threads";
+    }
+    else
+    #endif
+    {
+        for(std::size_t file = 0; file < paths.size(); file++) {
+            unread.push_back(file);
+        }
+    }
+    read_with_threads(paths, unread, depth, slots, queue);
+
+    queue.close();
+    for(auto &worker : workers) {
+        worker.join();
+    }
+    return statistics;
+}
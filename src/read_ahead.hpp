@@ -0,0 +1,49 @@
+#ifndef CARNAGE_REPORTER__READ_AHEAD_HPP
+#define CARNAGE_REPORTER__READ_AHEAD_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * A file read by read_ahead()
+ */
+struct FileContents {
+    /** Index of the file in the list given to read_ahead() */
+    std::size_t file;
+
+    /** Contents of the file, if it was read */
+    std::vector<std::byte> data;
+
+    /** errno from reading the file, or 0 if it was read */
+    int error;
+};
+
+/**
+ * How a read_ahead() call went
+ */
+struct ReadAheadStatistics {
+    /** How the files were read: "io_uring" or "threads" */
+    const char *backend;
+
+    /** Total time workers spent waiting for a file to be read, in seconds */
+    double wait_seconds;
+
+    /** Total time workers were running, in seconds */
+    double worker_seconds;
+};
+
+/**
+ * Read files into memory ahead of the workers that use them, keeping up to depth of them either being read or waiting
+ * for a worker. Files are read with io_uring where the kernel supports it, and by a pool of threads otherwise. Files
+ * are handed out roughly in order, but can finish in any order.
+ * @param paths        files to read
+ * @param depth        most files to read ahead at once
+ * @param worker_count number of workers
+ * @param use          called on a worker with each file and the worker's index
+ * @return             statistics
+ */
+ReadAheadStatistics read_ahead(const std::vector<std::string> &paths, std::size_t depth, std::size_t worker_count, const std::function<void (const FileContents &file, std::size_t worker)> &use);
+
+#endif
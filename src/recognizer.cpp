@@ -0,0 +1,599 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <unordered_map>
+
+#include "recognizer.hpp"
+#include "screenshot.hpp"
+#include "matcher.hpp"
+#include "error.hpp"
+
+/**
+ * Where a glyph of a string was read
+ */
+struct GlyphPosition {
+    std::uint32_t x;
+    std::uint32_t y;
+};
+
+/**
+ * Read a string by scoring every glyph at every position along it first, then finding the sequence of glyphs that
+ * matches the most pixels overall. The string can start up to 3 pixels off in either direction, and it ends where
+ * reading any further would only add glyphs that barely match.
+ * @param matcher   matcher for the screenshot
+ * @param table     glyphs that can be read
+ * @param search_x  left of the string
+ * @param search_y  top of the string
+ * @param max_x     right of the string
+ * @param positions set to the top left of each glyph read
+ * @param resource  where to allocate the scores and the string
+ * @return          string read
+ */
+static std::pmr::string decode_string(const Matcher &matcher, const std::vector<BitView> &table, std::uint32_t search_x, std::uint32_t search_y, std::uint32_t max_x, std::pmr::vector<GlyphPosition> &positions, std::pmr::memory_resource *resource) {
+    static constexpr std::uint32_t JITTER = 3;
+
+    // Glyphs that match worse than this cost more than they add, so the string can end before them
+    static constexpr double MINIMUM_GLYPH_MATCH = 0.75;
+
+    if(max_x <= search_x) {
+        return std::pmr::string(resource);
+    }
+
+    // Best score of each glyph at each x, over every y in the band
+    std::uint32_t min_x = search_x - JITTER;
+    std::uint32_t min_y = search_y - JITTER;
+    std::uint32_t columns = max_x - search_x + 2 * JITTER;
+    std::pmr::vector<float> scores(table.size() * columns, resource);
+    std::pmr::vector<std::uint32_t> rows(table.size() * columns, search_y, resource);
+    for(std::size_t g = 0; g < table.size(); g++) {
+        const auto &glyph = table[g];
+        auto *glyph_scores = scores.data() + g * columns;
+        auto *glyph_rows = rows.data() + g * columns;
+        auto map = matcher.correlate(glyph, min_x, min_y, min_x + columns, min_y + 2 * JITTER + 1);
+        for(std::uint32_t i = 0; i < columns; i++) {
+            for(std::uint32_t y = min_y; y <= search_y + JITTER; y++) {
+                float score;
+                if(map.has_value()) {
+                    score = map->at(min_x + i, y);
+                }
+                else if(matcher.upper_bound(glyph, min_x + i, y) > glyph_scores[i]) {
+                    score = matcher.match_bounded(glyph, min_x + i, y, glyph_scores[i]);
+                }
+                else {
+                    continue;
+                }
+                if(score > glyph_scores[i]) {
+                    glyph_scores[i] = score;
+                    glyph_rows[i] = y;
+                }
+            }
+        }
+    }
+
+    // Weigh each glyph by its size so wider glyphs count for more, and find the best way to read the rest of the string
+    // from each x, going backwards. Ending the string is worth nothing. Unlike reading one glyph at a time, each glyph
+    // starts exactly where the one before it ended, so only the first glyph can be off by a few pixels.
+    std::pmr::vector<double> best(columns + 1, resource);
+    std::pmr::vector<std::optional<std::size_t>> best_glyph(columns + 1, resource);
+    for(std::uint32_t i = columns; i-- > 0;) {
+        for(std::size_t g = 0; g < table.size(); g++) {
+            const auto &glyph = table[g];
+            float score = scores[g * columns + i];
+            if(glyph.width == 0 || min_x + i + glyph.width * 0.5F > max_x || score <= 0.0F) {
+                continue;
+            }
+
+            std::uint32_t next = i + glyph.width;
+            double value = static_cast<double>(glyph.width) * glyph.height * (score - MINIMUM_GLYPH_MATCH) + (next < columns ? best[next] : 0.0);
+            if(value > best[i]) {
+                best[i] = value;
+                best_glyph[i] = g;
+            }
+        }
+    }
+
+    // Start where some glyph fits best, like reading one glyph at a time would; starting anywhere else just adds glyphs
+    // for the background before the string
+    std::optional<std::uint32_t> first;
+    float first_score = 0.0F;
+    for(std::uint32_t i = 0; i <= 2 * JITTER && i < columns; i++) {
+        for(std::size_t g = 0; g < table.size(); g++) {
+            if(best_glyph[i].has_value() && scores[g * columns + i] > first_score) {
+                first_score = scores[g * columns + i];
+                first = i;
+            }
+        }
+    }
+
+    std::pmr::string decoded(resource);
+    positions.clear();
+    for(auto i = first; i.has_value() && *i < columns && best_glyph[*i].has_value();) {
+        const auto &glyph = table[*best_glyph[*i]];
+        decoded += glyph.text[0];
+        positions.push_back(GlyphPosition { min_x + *i, rows[*best_glyph[*i] * columns + *i] });
+        i = *i + glyph.width;
+    }
+    return decoded;
+}
+
+Recognizer::Recognizer(CompiledFont font, Roster roster, RecognizerOptions options) : font(std::move(font)), options(options), roster(std::move(roster)), roster_index(this->roster.get_names()), glyph_trie(this->roster.get_names(), this->font.get_characters()), confusion(this->font.get_characters()) {
+    this->line_height_search = this->font.get_ascending_height();
+
+    // Render the headers
+    for(const char *header : { "Name", "Score", "Kills", "Assists", "Deaths" }) {
+        this->headers.emplace_back(this->font.draw(header));
+    }
+}
+
+Recognizer::Recognizer(const FontTag &font_tag, const std::vector<std::string> &names, RecognizerOptions options) : Recognizer(compile(font_tag, names), options) {}
+
+Recognizer::Recognizer(std::pair<CompiledFont, Roster> compiled, RecognizerOptions options) : Recognizer(std::move(compiled.first), std::move(compiled.second), options) {}
+
+std::pair<CompiledFont, Roster> Recognizer::compile(const FontTag &font_tag, const std::vector<std::string> &names) {
+    // The names are rendered with the compiled font, so it has to be compiled first
+    auto font = CompiledFont::compile(font_tag);
+    auto roster = Roster::render(font, names);
+    return { std::move(font), std::move(roster) };
+}
+
+std::vector<PlayerStats> Recognizer::recognize(const char *path) const {
+    ScratchArena arena;
+    std::vector<PlayerStats> players;
+    this->recognize(path, arena, players);
+    return players;
+}
+
+void Recognizer::recognize(const char *path, ScratchArena &arena, std::vector<PlayerStats> &players) const {
+    // Everything from the last screenshot is gone by now
+    arena.reset();
+    this->read_screenshot(load_screenshot(path, &arena), arena, players);
+}
+
+std::vector<PlayerStats> Recognizer::recognize(const std::uint8_t *rgba, std::uint32_t width, std::uint32_t height) const {
+    ScratchArena arena;
+    std::vector<PlayerStats> players;
+    this->recognize(rgba, width, height, arena, players);
+    return players;
+}
+
+void Recognizer::recognize(const std::uint8_t *rgba, std::uint32_t width, std::uint32_t height, ScratchArena &arena, std::vector<PlayerStats> &players) const {
+    arena.reset();
+    this->read_screenshot(make_screenshot(rgba, width, height, 4, &arena), arena, players);
+}
+
+std::vector<PlayerStats> Recognizer::recognize(const std::byte *data, std::size_t size) const {
+    ScratchArena arena;
+    std::vector<PlayerStats> players;
+    this->recognize(data, size, arena, players);
+    return players;
+}
+
+void Recognizer::recognize(const std::byte *data, std::size_t size, ScratchArena &arena, std::vector<PlayerStats> &players) const {
+    arena.reset();
+    this->read_screenshot(decode_screenshot(data, size, &arena), arena, players);
+}
+
+void Recognizer::recognize(const Screenshot &screenshot, ScratchArena &arena, std::vector<PlayerStats> &players) const {
+    arena.reset();
+    this->read_screenshot(screenshot, arena, players);
+}
+
+std::array<MatchPosition, 5> Recognizer::find_headers(const Matcher &matcher) const {
+    const auto &width = matcher.get_image().width;
+    const auto &line_height_search = this->line_height_search;
+    const auto &headers = this->headers;
+
+    std::array<MatchPosition, 5> found;
+    for(std::size_t h = 0; h < found.size(); h++) {
+        std::uint32_t min_x = h == 0 ? 120 : found[h - 1].x;
+        std::uint32_t min_y = h == 0 ? 120 : found[0].y - 10;
+        found[h] = matcher.find_best(headers[h], min_x, min_y, width, min_y + line_height_search, MINIMUM_HEADER_MATCH);
+
+        if(found[h].score < MINIMUM_HEADER_MATCH) {
+            const char *text = headers[h].text.text.data();
+            auto message = format_message("Failed to find \"%s\". Best guess was %u,%u, but we only got a %f%% match.", text, found[h].x, found[h].y, found[h].score * 100.0F);
+            throw CarnageError(ErrorKind::HEADER_NOT_FOUND, message, HeaderMiss { text, found[h].score, found[h].x, found[h].y });
+        }
+    }
+    return found;
+}
+
+void Recognizer::read_screenshot(const Screenshot &screenshot, ScratchArena &arena, std::vector<PlayerStats> &players) const {
+    const auto &monochrome_version = screenshot.monochrome;
+    const auto &width = monochrome_version.width;
+
+    if(monochrome_version.height != 480) {
+        throw_error(ErrorKind::UNSUPPORTED_SIZE, "Cannot support non-480p images right now...");
+    }
+
+    const auto &font = this->font;
+    const auto &line_height_search = this->line_height_search;
+    const auto &numbers = font.get_numbers();
+    const auto &all = font.get_characters();
+    const auto &roster_names = this->roster.get_names();
+    const auto &confusion = this->confusion;
+
+    Matcher matcher(monochrome_version, &arena);
+
+    // Names that haven't been matched to a player yet
+    std::pmr::vector<bool> name_available(roster_names.size(), true, &arena);
+    std::size_t names_left = roster_names.size();
+
+    // Find the headers
+    auto headers = this->find_headers(matcher);
+    std::uint32_t name_x = headers[0].x;
+    std::uint32_t name_y = headers[0].y;
+    std::uint32_t score_x = headers[1].x;
+    std::uint32_t kills_x = headers[2].x;
+    std::uint32_t assists_x = headers[3].x;
+    std::uint32_t deaths_x = headers[4].x;
+
+    std::uint32_t y_cursor = name_y;
+
+    // Skip to the next line
+    auto skip_to_next_line = [&y_cursor, &monochrome_version, &line_height_search, &deaths_x, &width]() {
+        y_cursor += line_height_search / 2;
+
+        while(y_cursor < 480) {
+            bool should_break = true;
+
+            // See if there's anything this line. Checking deaths is fastest since it is rightmost
+            for(std::uint32_t x = deaths_x; x < width; x++) {
+                if(monochrome_version.get(x, y_cursor)) {
+                    should_break = false;
+                    break;
+                }
+            }
+            if(should_break) {
+                break;
+            }
+            y_cursor++;
+        }
+    };
+
+    skip_to_next_line();
+
+    // Rows already in players are overwritten before any are added
+    std::size_t player_count = 0;
+
+    // Go through each line
+    while(true) {
+        // See if there's something on this line. Checking deaths is fastest since it's the rightmost
+        bool found_something = false;
+        for(std::uint32_t y = y_cursor; y < y_cursor + line_height_search && !found_something; y++) {
+            for(std::uint32_t x = deaths_x; x < width && !found_something; x++) {
+                found_something = monochrome_version.get(x, y);
+            }
+        }
+
+        if(!found_something) {
+            break;
+        }
+
+        // Let's get some numbers
+        auto string_at = [this, &arena, &matcher, &width, &line_height_search, &monochrome_version, &confusion](std::uint32_t search_x, std::uint32_t search_y, std::uint32_t end_x, const std::vector<BitView> &table, bool fix_string = false) -> std::pmr::string {
+            std::uint32_t x = search_x;
+
+            // Get the length of the string
+            std::uint32_t max_x;
+            std::uint32_t drought = 0;
+            for(max_x = x + 1; max_x < end_x; max_x++) {
+                drought++;
+                for(std::uint32_t y = search_y + 4; y < search_y + line_height_search; y++) {
+                    if(monochrome_version.get(max_x, y)) {
+                        drought = 0;
+                        break;
+                    }
+                }
+            }
+            max_x -= drought;
+
+            std::pmr::string final_string(&arena);
+            std::pmr::vector<GlyphPosition> positions(&arena);
+
+            // Glyphs have to match at least this well to keep following the roster's names
+            static constexpr float MINIMUM_TRIE_GLYPH_MATCH = 0.90F;
+
+            // Names can be read by following the roster's names for as long as one of them fits
+            const auto &glyph_trie = this->glyph_trie;
+            bool following_roster = fix_string && this->options.roster_decoding && !glyph_trie.empty();
+            std::uint32_t trie_node = GlyphTrie::ROOT;
+            std::pmr::vector<const BitView *> glyphs(&arena);
+
+            // Either read the whole string at once, or one glyph at a time
+            if(this->options.dp_decoding && !following_roster) {
+                final_string = decode_string(matcher, table, x, search_y, max_x, positions, &arena);
+
+                // Check glyphs that are easily mistaken for others on just the pixels that tell them apart. Everything
+                // after a glyph that turns out to be wider or narrower was read from the wrong place, so read it again.
+                std::pmr::vector<GlyphPosition> rest_positions(&arena);
+                for(std::size_t i = 0; fix_string && i < final_string.size(); i++) {
+                    char fixed = confusion.disambiguate(monochrome_version, final_string[i], positions[i].x, positions[i].y);
+                    if(fixed == final_string[i]) {
+                        continue;
+                    }
+
+                    bool moved = confusion.get_advance(fixed) != confusion.get_advance(final_string[i]);
+                    final_string[i] = fixed;
+                    if(moved) {
+                        auto rest = decode_string(matcher, table, positions[i].x + confusion.get_advance(fixed), search_y, max_x, rest_positions, &arena);
+                        final_string.resize(i + 1);
+                        final_string += rest;
+                        positions.resize(i + 1);
+                        positions.insert(positions.end(), rest_positions.begin(), rest_positions.end());
+                    }
+                }
+            }
+            else {
+                while(x < max_x) {
+                    float best_character_percent = 0.0F;
+                    char best_character = 0;
+                    std::optional<std::uint32_t> best_length;
+                    std::uint32_t best_x = 0;
+                    std::uint32_t best_y = 0;
+
+                    glyphs.clear();
+                    if(following_roster) {
+                        glyph_trie.get_glyphs(trie_node, glyphs);
+                    }
+                    if(glyphs.empty()) {
+                        following_roster = false;
+                        for(auto &c : table) {
+                            glyphs.push_back(&c);
+                        }
+                    }
+
+                    // Give some leeway for a few pixels
+                    for(std::int32_t my = -3; my < 4; my++) {
+                        for(std::int32_t mx = -3; mx < 4; mx++) {
+                            for(const auto *glyph : glyphs) {
+                                const auto &c = *glyph;
+                                if(x + c.width * 0.5F > max_x || matcher.upper_bound(c, x + mx, search_y + my) <= best_character_percent) {
+                                    continue;
+                                }
+
+                                float test = matcher.match_bounded(c, x + mx, search_y + my, best_character_percent);
+                                if(test > best_character_percent) {
+                                    best_character_percent = test;
+                                    best_character = c.text[0];
+                                    best_length = c.width;
+                                    best_x = mx;
+                                    best_y = my;
+                                }
+                            }
+                        }
+                    }
+
+                    // If no roster name fits here, read the rest of the name from every glyph
+                    if(following_roster && (!best_length.has_value() || best_character_percent < MINIMUM_TRIE_GLYPH_MATCH)) {
+                        following_roster = false;
+                        continue;
+                    }
+
+                    if(!best_length.has_value()) {
+                        break;
+                    }
+
+                    // Check glyphs that are easily mistaken for others on just the pixels that tell them apart, and
+                    // read the next glyph from wherever the one that is really here ends
+                    if(fix_string) {
+                        char fixed = confusion.disambiguate(monochrome_version, best_character, x + best_x, search_y + best_y);
+                        if(fixed != best_character) {
+                            best_character = fixed;
+                            best_length = confusion.get_advance(fixed);
+                        }
+                    }
+
+                    if(following_roster) {
+                        auto child = glyph_trie.get_child(trie_node, best_character);
+                        following_roster = child.has_value();
+                        trie_node = child.value_or(GlyphTrie::ROOT);
+                    }
+
+                    positions.push_back(GlyphPosition { x + best_x, search_y + best_y });
+                    x += best_length.value();
+                    final_string += best_character;
+                }
+            }
+
+            // Strip off whitespace at the end
+            while(final_string.size() && final_string[final_string.size() - 1] == ' ') {
+                final_string.erase(final_string.end() - 1);
+                positions.pop_back();
+            }
+
+            return final_string;
+        };
+
+        auto &player = player_count < players.size() ? players[player_count] : players.emplace_back();
+        player_count++;
+        player.red = false;
+
+        // Determine if it was red or blue
+        bool found = false;
+        for(std::uint32_t y = y_cursor; y < y_cursor + line_height_search; y++) {
+            for(std::uint32_t x = name_x; x < kills_x && !found; x++) {
+                if(screenshot.bright.get(x, y)) {
+                    player.red = screenshot.red.get(x, y);
+                    found = true;
+                    break;
+                }
+            }
+        }
+
+        // Use a names file
+        bool name_found = false;
+        if(names_left) {
+            static constexpr float MINIMUM_NAME_MATCH = 0.80F;
+            float best_match_percent = 0.0F;
+            std::size_t best_match_index = 0;
+
+            // Scores of the whole neighborhood, for names that turn out to be worth scoring at all
+            std::pmr::unordered_map<std::size_t, std::optional<ScoreMap>> name_scores(&arena);
+            std::pmr::vector<RosterCandidate> candidates(&arena);
+
+            for(std::int32_t my = -2; my < 3; my++) {
+                for(std::int32_t mx = -2; mx < 3; mx++) {
+                    // Names that can't clear the minimum here are left out by the index
+                    this->roster_index.find_candidates(matcher, name_x + mx, y_cursor + my, MINIMUM_NAME_MATCH, candidates);
+
+                    for(auto &candidate : candidates) {
+                        // Names that can't beat the best so far can't be picked
+                        if(!name_available[candidate.name] || candidate.bound <= best_match_percent) {
+                            continue;
+                        }
+
+                        const auto &name = roster_names[candidate.name];
+                        auto scores = name_scores.find(candidate.name);
+                        if(scores == name_scores.end()) {
+                            scores = name_scores.emplace(candidate.name, matcher.correlate(name, name_x - 2, y_cursor - 2, name_x + 3, y_cursor + 3)).first;
+                        }
+
+                        float match_percent = scores->second.has_value() ? scores->second->at(name_x + mx, y_cursor + my) : matcher.match_bounded(name, name_x + mx, y_cursor + my, std::max(best_match_percent, MINIMUM_NAME_MATCH));
+                        if(best_match_percent < match_percent) {
+                            best_match_percent = match_percent;
+                            best_match_index = candidate.name;
+                        }
+                    }
+                }
+            }
+
+            // Use the name from the names file if it's close enough
+            if(best_match_percent > MINIMUM_NAME_MATCH) {
+                player.name = roster_names[best_match_index].text;
+                name_available[best_match_index] = false;
+                names_left--;
+                name_found = true;
+            }
+        }
+        if(!name_found) {
+            auto name = string_at(name_x, y_cursor, score_x, all, true);
+            player.name.assign(name.data(), name.size());
+        }
+
+        player.score = std::strtol(string_at(score_x, y_cursor, kills_x, numbers).data(), nullptr, 10);
+        player.kills = std::strtol(string_at(kills_x, y_cursor, assists_x, numbers).data(), nullptr, 10);
+        player.assists = std::strtol(string_at(assists_x, y_cursor, deaths_x, numbers).data(), nullptr, 10);
+        player.deaths = std::strtol(string_at(deaths_x, y_cursor, width, numbers).data(), nullptr, 10);
+
+        skip_to_next_line();
+    }
+    players.resize(player_count);
+
+    // Keep track of how much work the matcher did
+    std::lock_guard<std::mutex> lock(this->statistics_mutex);
+    this->statistics.add(matcher.get_statistics());
+}
+
+bool read_names_file(const char *path, std::vector<std::string> &names) {
+    std::ifstream input_stream(path);
+    if(!input_stream.is_open()) {
+        return false;
+    }
+    std::string line;
+    while(std::getline(input_stream, line)) {
+        names.emplace_back(std::move(line));
+    }
+    return true;
+}
+
+void write_csv_header(std::FILE *output, bool image_column) {
+    std::fprintf(output, "%sname,place,team,score,kills,assists,deaths\n", image_column ? "image," : "");
+}
+
+void write_csv(std::FILE *output, const std::vector<PlayerStats> &players, const char *image_name) {
+    // Determine if it's free-for-all
+    bool ffa = true;
+    for(auto &player : players) {
+        if(player.red) {
+            ffa = false;
+            break;
+        }
+    }
+
+    // Determine what place people are in
+    std::vector<std::size_t> places;
+    for(auto &player : players) {
+        std::size_t players_below = 0;
+        for(auto &player_test : players) {
+            if(&player == &player_test) {
+                continue;
+            }
+
+            #define CHECK_STAT(stat, good_operator, bad_operator) if(player.stat good_operator player_test.stat) {continue;} else if(player.stat bad_operator player_test.stat) {players_below++; continue;}
+
+            CHECK_STAT(score, >, <);
+            CHECK_STAT(kills, >, <);
+            CHECK_STAT(deaths, <, >);
+            CHECK_STAT(assists, >, <);
+
+            #undef CHECK_STAT
+
+            players_below++;
+        }
+
+        places.push_back(players_below + 1);
+    }
+
+    // Merged reports get the image as the first column
+    const char *image_prefix = image_name ? image_name : "";
+    const char *image_separator = image_name ? "," : "";
+
+    // Begin
+    PlayerStats teams[2] = {};
+    for(std::size_t p = 0; p < players.size(); p++) {
+        auto &place = places[p];
+        auto &player = players[p];
+        const char *th = "th";
+
+        if((place % 100) < 10 || (place % 100) >= 19) {
+            switch(place % 10) {
+                case 1:
+                    th = "st";
+                    break;
+                case 2:
+                    th = "nd";
+                    break;
+                case 3:
+                    th = "rd";
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // Write it!
+        std::fprintf(
+            output,
+            "%s%s%s,%zu%s,%s,%i,%i,%i,%i\n",
+            image_prefix,
+            image_separator,
+            player.name.data(),
+            place,
+            th,
+            ffa ? "ffa" : (player.red ? "red" : "blue"),
+            player.score,
+            player.kills,
+            player.assists,
+            player.deaths
+        );
+
+        // Tally up scores
+        auto &team = teams[player.red];
+        team.score += player.score;
+        team.kills += player.kills;
+        team.assists += player.assists;
+        team.deaths += player.deaths;
+    }
+
+    #define PRINT_TEAM_TOTAL(team_name, team_index) std::fprintf(output, "%s%s" team_name ",%s,%s,%i,%i,%i,%i\n", image_prefix, image_separator, teams[team_index].score > teams[!team_index].score ? "1st" : "2nd", team_index ? "red" : "blue", teams[team_index].score, teams[team_index].kills, teams[team_index].assists, teams[team_index].deaths);
+
+    if(!ffa) {
+        PRINT_TEAM_TOTAL("red_team_total", 1);
+        PRINT_TEAM_TOTAL("blue_team_total", 0);
+    }
+
+    #undef PRINT_TEAM_TOTAL
+}
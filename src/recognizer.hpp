@@ -0,0 +1,235 @@
+#ifndef CARNAGE_REPORTER__RECOGNIZER_HPP
+#define CARNAGE_REPORTER__RECOGNIZER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "compiled_font.hpp"
+#include "roster.hpp"
+#include "roster_index.hpp"
+#include "glyph_trie.hpp"
+#include "confusion.hpp"
+#include "scratch_arena.hpp"
+#include "screenshot.hpp"
+#include "error.hpp"
+#include "bit_image.hpp"
+#include "matcher.hpp"
+
+/**
+ * A single row of a postgame carnage report
+ */
+struct PlayerStats {
+    bool red;
+    std::string name;
+    std::int8_t score;
+    std::int8_t kills;
+    std::int8_t assists;
+    std::int8_t deaths;
+};
+
+/**
+ * Ways of reading screenshots that can change what gets read, so they are off unless asked for
+ */
+struct RecognizerOptions {
+    /**
+     * Read names that don't match anyone on the roster by only trying glyphs that continue some roster name, falling back
+     * to trying every glyph once no roster name fits
+     */
+    bool roster_decoding = false;
+
+    /**
+     * Read strings by scoring every glyph along the string first and picking the sequence of glyphs that matches best
+     * overall, rather than the best glyph at each step. Roster decoding takes precedence for names.
+     */
+    bool dp_decoding = false;
+};
+
+/**
+ * Score each column header has to match with somewhere for a screenshot to be read
+ */
+static constexpr float MINIMUM_HEADER_MATCH = 0.85F;
+
+/**
+ * Reads postgame carnage report screenshots. Everything that depends only on the font and the names files is built once
+ * on construction, so one recognizer can be shared by any number of threads reading screenshots concurrently. Nothing
+ * here exits the program; screenshots that can't be read throw a CarnageError.
+ */
+class Recognizer {
+public:
+    /**
+     * Read a screenshot
+     * @param path path to the screenshot
+     * @return     players in the order they appear on the screenshot
+     */
+    std::vector<PlayerStats> recognize(const char *path) const;
+
+    /**
+     * Read a screenshot, taking everything that is only needed while reading it from an arena. A thread that keeps
+     * reusing the same arena and players makes no heap allocations once they have grown to fit.
+     * @param path    path to the screenshot
+     * @param arena   arena to reset and then read with
+     * @param players set to the players in the order they appear on the screenshot, reusing the rows already in it
+     */
+    void recognize(const char *path, ScratchArena &arena, std::vector<PlayerStats> &players) const;
+
+    /**
+     * Read a screenshot that is already decoded
+     * @param rgba   pixels, row by row, with four bytes (red, green, blue, and alpha) per pixel
+     * @param width  width in pixels
+     * @param height height in pixels
+     * @return       players in the order they appear on the screenshot
+     */
+    std::vector<PlayerStats> recognize(const std::uint8_t *rgba, std::uint32_t width, std::uint32_t height) const;
+
+    /**
+     * Read a screenshot that is already decoded, taking everything that is only needed while reading it from an arena
+     * @param rgba    pixels, row by row, with four bytes (red, green, blue, and alpha) per pixel
+     * @param width   width in pixels
+     * @param height  height in pixels
+     * @param arena   arena to reset and then read with
+     * @param players set to the players in the order they appear on the screenshot, reusing the rows already in it
+     */
+    void recognize(const std::uint8_t *rgba, std::uint32_t width, std::uint32_t height, ScratchArena &arena, std::vector<PlayerStats> &players) const;
+
+    /**
+     * Read a screenshot that is still encoded, such as the contents of a PNG file
+     * @param data encoded screenshot
+     * @param size size of the encoded screenshot in bytes
+     * @return     players in the order they appear on the screenshot
+     */
+    std::vector<PlayerStats> recognize(const std::byte *data, std::size_t size) const;
+
+    /**
+     * Read a screenshot that is still encoded, taking everything that is only needed while reading it from an arena
+     * @param data    encoded screenshot
+     * @param size    size of the encoded screenshot in bytes
+     * @param arena   arena to reset and then read with
+     * @param players set to the players in the order they appear on the screenshot, reusing the rows already in it
+     */
+    void recognize(const std::byte *data, std::size_t size, ScratchArena &arena, std::vector<PlayerStats> &players) const;
+
+    /**
+     * Read a screenshot that has already been decoded and reduced to bit planes, such as on another thread, taking
+     * everything that is only needed while reading it from an arena
+     * @param screenshot screenshot, which must not be allocated from the arena
+     * @param arena      arena to reset and then read with
+     * @param players    set to the players in the order they appear on the screenshot, reusing the rows already in it
+     */
+    void recognize(const Screenshot &screenshot, ScratchArena &arena, std::vector<PlayerStats> &players) const;
+
+    /**
+     * Find the column headers of a screenshot. Name is searched for first, then Score, Kills, Assists, and Deaths, each
+     * from wherever the one before it is to the right edge, in a band a line tall starting just above Name. A header
+     * that doesn't match well enough anywhere throws a HEADER_NOT_FOUND CarnageError with the best guess for it.
+     * @param matcher matcher for the screenshot
+     * @return        where Name, Score, Kills, Assists, and Deaths are, in that order
+     */
+    std::array<MatchPosition, 5> find_headers(const Matcher &matcher) const;
+
+    /**
+     * Get how much template matching has been done and avoided across every screenshot read so far
+     * @return statistics
+     */
+    MatchStatistics get_match_statistics() const {
+        std::lock_guard<std::mutex> lock(this->statistics_mutex);
+        return this->statistics;
+    }
+
+    /**
+     * Get the font screenshots are read with
+     * @return compiled font
+     */
+    const CompiledFont &get_font() const {
+        return this->font;
+    }
+
+    /**
+     * Get the options screenshots are read with
+     * @return options
+     */
+    const RecognizerOptions &get_options() const {
+        return this->options;
+    }
+
+    /**
+     * Render the headers for the given font
+     * @param font    compiled font, which already has the glyph tables
+     * @param roster  names to look for, rendered with the same font
+     * @param options options
+     */
+    Recognizer(CompiledFont font, Roster roster, RecognizerOptions options = {});
+
+    /**
+     * Compile a font tag and render the names with it
+     * @param font_tag font tag
+     * @param names    names to look for
+     * @param options  options
+     */
+    Recognizer(const FontTag &font_tag, const std::vector<std::string> &names = {}, RecognizerOptions options = {});
+
+private:
+    Recognizer(std::pair<CompiledFont, Roster> compiled, RecognizerOptions options);
+    static std::pair<CompiledFont, Roster> compile(const FontTag &font_tag, const std::vector<std::string> &names);
+
+    /**
+     * Read a screenshot once the arena has been reset
+     * @param screenshot screenshot, which may have been loaded from the arena
+     * @param arena      arena to read with
+     * @param players    set to the players in the order they appear on the screenshot
+     */
+    void read_screenshot(const Screenshot &screenshot, ScratchArena &arena, std::vector<PlayerStats> &players) const;
+
+    CompiledFont font;
+    RecognizerOptions options;
+    std::uint32_t line_height_search;
+
+    /** Column headers: Name, Score, Kills, Assists, and Deaths */
+    std::vector<PyramidTemplate> headers;
+
+    /** Rendered names from the names files, if any */
+    Roster roster;
+
+    /** Index for ruling out most of the names at a position at once */
+    RosterIndex roster_index;
+
+    /** Roster names spelled out glyph by glyph, for roster decoding */
+    GlyphTrie glyph_trie;
+
+    /** Glyphs that are easily mistaken for each other */
+    ConfusionTable confusion;
+
+    /** Matching done across every screenshot */
+    mutable std::mutex statistics_mutex;
+    mutable MatchStatistics statistics;
+};
+
+/**
+ * Read every line of a names file
+ * @param path  path to the names file
+ * @param names names to append to
+ * @return      true if the file could be opened
+ */
+bool read_names_file(const char *path, std::vector<std::string> &names);
+
+/**
+ * Write the CSV header line
+ * @param output       file to write to
+ * @param image_column whether or not rows have an image column (used for merging several reports)
+ */
+void write_csv_header(std::FILE *output, bool image_column = false);
+
+/**
+ * Write a postgame carnage report as CSV rows
+ * @param output     file to write to
+ * @param players    players to write
+ * @param image_name if non-null, add this as the first column of each row
+ */
+void write_csv(std::FILE *output, const std::vector<PlayerStats> &players, const char *image_name = nullptr);
+
+#endif
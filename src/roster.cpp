@@ -0,0 +1,157 @@
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+#include "roster.hpp"
+#include "hash.hpp"
+
+static constexpr char ROSTER_MAGIC[8] = { 'C', 'R', 'R', 'O', 'S', 'T', 'E', 'R' };
+static constexpr std::uint32_t ROSTER_VERSION = 1;
+static constexpr std::uint32_t ROSTER_BYTE_ORDER = 0x01020304;
+
+/**
+ * Hash names in order, including where each one ends
+ * @param names names
+ * @return      hash
+ */
+static std::uint64_t hash_names(const std::vector<std::string> &names) {
+    std::uint64_t hash = hash_bytes(nullptr, 0);
+    for(auto &name : names) {
+        std::uint64_t size = name.size();
+        hash = hash_bytes(&size, sizeof(size), hash);
+        hash = hash_bytes(name.data(), name.size(), hash);
+    }
+    return hash;
+}
+
+Roster Roster::render(const CompiledFont &font, const std::vector<std::string> &names, const Roster *previous) {
+    // Names the previous roster already rendered don't need to be rendered again
+    std::unordered_map<std::string_view, const BitView *> previous_names;
+    if(previous) {
+        for(auto &name : previous->names) {
+            previous_names.emplace(name.text, &name);
+        }
+    }
+
+    RosterHeader header = {};
+    std::memcpy(header.magic, ROSTER_MAGIC, sizeof(header.magic));
+    header.version = ROSTER_VERSION;
+    header.byte_order = ROSTER_BYTE_ORDER;
+    header.font_hash = font.get_source_hash();
+    header.names_hash = hash_names(names);
+    header.name_count = names.size();
+
+    std::vector<RosterEntry> entries(names.size());
+    std::vector<BitImage> rendered(names.size());
+    std::vector<const BitView *> templates(names.size());
+    for(std::size_t i = 0; i < names.size(); i++) {
+        auto found = previous_names.find(names[i]);
+        if(found != previous_names.end()) {
+            templates[i] = found->second;
+        }
+        else {
+            rendered[i] = font.draw(names[i].data());
+        }
+
+        BitView view = templates[i] ? *templates[i] : BitView(rendered[i]);
+        auto &entry = entries[i];
+        entry.text_offset = header.text_size;
+        entry.text_size = static_cast<std::uint32_t>(names[i].size());
+        entry.width = view.width;
+        entry.height = view.height;
+        entry.ink = view.ink;
+        entry.last_column_mask = view.last_column_mask;
+        entry.words_offset = header.word_count;
+        header.text_size += names[i].size();
+        header.word_count += static_cast<std::uint64_t>((view.width + 63) / 64) * view.height;
+    }
+
+    // Lay out the file, keeping every section 8-byte aligned
+    auto align = [](std::uint64_t offset) -> std::uint64_t {
+        return (offset + 7) & ~std::uint64_t(7);
+    };
+    header.entries_offset = align(sizeof(header));
+    header.text_offset = align(header.entries_offset + entries.size() * sizeof(RosterEntry));
+    header.words_offset = align(header.text_offset + header.text_size);
+    header.file_size = header.words_offset + header.word_count * sizeof(std::uint64_t);
+
+    Roster roster;
+    roster.owned.resize(header.file_size);
+    auto *output = roster.owned.data();
+    std::memcpy(output, &header, sizeof(header));
+    std::memcpy(output + header.entries_offset, entries.data(), entries.size() * sizeof(RosterEntry));
+    for(std::size_t i = 0; i < names.size(); i++) {
+        std::memcpy(output + header.text_offset + entries[i].text_offset, names[i].data(), names[i].size());
+
+        const auto *words = templates[i] ? templates[i]->words : rendered[i].words.data();
+        std::size_t word_count = static_cast<std::size_t>((entries[i].width + 63) / 64) * entries[i].height;
+        std::memcpy(output + header.words_offset + entries[i].words_offset * sizeof(std::uint64_t), words, word_count * sizeof(std::uint64_t));
+    }
+
+    roster.bind(roster.owned.data(), roster.owned.size());
+    return roster;
+}
+
+std::optional<Roster> Roster::load(const char *path, std::uint64_t font_hash) {
+    Roster roster;
+    if(!roster.mapped.open(path) || !roster.bind(roster.mapped.data(), roster.mapped.size()) || roster.header->font_hash != font_hash) {
+        return std::nullopt;
+    }
+    return roster;
+}
+
+bool Roster::save(const char *path) const {
+    return replace_file(path, this->data, this->size);
+}
+
+bool Roster::has_names(const std::vector<std::string> &names) const {
+    if(this->names.size() != names.size() || this->header->names_hash != hash_names(names)) {
+        return false;
+    }
+    for(std::size_t i = 0; i < names.size(); i++) {
+        if(this->names[i].text != names[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Roster::bind(const std::byte *data, std::size_t size) {
+    if(!data || size < sizeof(RosterHeader)) {
+        return false;
+    }
+
+    const auto *header = reinterpret_cast<const RosterHeader *>(data);
+    if(std::memcmp(header->magic, ROSTER_MAGIC, sizeof(header->magic)) != 0 || header->version != ROSTER_VERSION || header->byte_order != ROSTER_BYTE_ORDER || header->file_size != size) {
+        return false;
+    }
+
+    // Every section has to be aligned and lie within the file
+    auto section_fits = [&size](std::uint64_t offset, std::uint64_t count, std::uint64_t element_size) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / element_size;
+    };
+    if(!section_fits(header->entries_offset, header->name_count, sizeof(RosterEntry)) ||
+       !section_fits(header->text_offset, header->text_size, 1) ||
+       !section_fits(header->words_offset, header->word_count, sizeof(std::uint64_t))) {
+        return false;
+    }
+
+    const auto *entries = reinterpret_cast<const RosterEntry *>(data + header->entries_offset);
+    const auto *text = reinterpret_cast<const char *>(data + header->text_offset);
+    const auto *words = reinterpret_cast<const std::uint64_t *>(data + header->words_offset);
+    std::vector<BitView> names;
+    for(std::uint64_t i = 0; i < header->name_count; i++) {
+        const auto &e = entries[i];
+        std::uint64_t word_count = static_cast<std::uint64_t>((e.width + 63) / 64) * e.height;
+        if(e.text_offset > header->text_size || e.text_size > header->text_size - e.text_offset || e.words_offset > header->word_count || word_count > header->word_count - e.words_offset) {
+            return false;
+        }
+        names.push_back(BitView { e.width, e.height, e.last_column_mask, e.ink, words + e.words_offset, std::string_view(text + e.text_offset, e.text_size) });
+    }
+
+    this->data = data;
+    this->size = size;
+    this->header = header;
+    this->names = std::move(names);
+    return true;
+}
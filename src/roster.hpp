@@ -0,0 +1,134 @@
+#ifndef CARNAGE_REPORTER__ROSTER_HPP
+#define CARNAGE_REPORTER__ROSTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "compiled_font.hpp"
+#include "bit_image.hpp"
+#include "mapped_file.hpp"
+
+/**
+ * A rendered name of a roster file
+ */
+struct RosterEntry {
+    /** Offset of the name, in bytes from the start of the text section */
+    std::uint64_t text_offset;
+    std::uint32_t text_size;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t ink;
+    std::uint64_t last_column_mask;
+
+    /** Offset of the first word, in words from the start of the words section */
+    std::uint64_t words_offset;
+};
+static_assert(sizeof(RosterEntry) == 0x28);
+
+/**
+ * Start of a roster file. Offsets are in bytes from the start of the file, and everything is in the byte order of the
+ * machine that wrote it.
+ */
+struct RosterHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+
+    /** Hash of the font tag the names were rendered with */
+    std::uint64_t font_hash;
+
+    /** Hash of every name, in order */
+    std::uint64_t names_hash;
+    std::uint64_t file_size;
+    std::uint64_t name_count;
+    std::uint64_t text_size;
+    std::uint64_t word_count;
+
+    /** name_count RosterEntry */
+    std::uint64_t entries_offset;
+
+    /** text_size bytes of names, not null terminated */
+    std::uint64_t text_offset;
+
+    /** word_count 64-bit words of template pixels */
+    std::uint64_t words_offset;
+};
+static_assert(sizeof(RosterHeader) == 0x58);
+
+/**
+ * Names from the names files, rendered into templates. A roster can be saved to a file and mapped back in later, so a
+ * long list of names only has to be rendered again when the names or the font change.
+ */
+class Roster {
+public:
+    /**
+     * Render names
+     * @param font     font to render with
+     * @param names    names, in order
+     * @param previous roster to copy any names it already has from instead of rendering them, if any
+     * @return         roster
+     */
+    static Roster render(const CompiledFont &font, const std::vector<std::string> &names, const Roster *previous = nullptr);
+
+    /**
+     * Map a roster file
+     * @param path      path to the file
+     * @param font_hash hash of the font tag the names have to have been rendered with
+     * @return          roster, or nothing if the file is missing, invalid, or was rendered with another font
+     */
+    static std::optional<Roster> load(const char *path, std::uint64_t font_hash);
+
+    /**
+     * Write the roster to a file, replacing it in one step
+     * @param path path to the file
+     * @return     true if the file was written
+     */
+    bool save(const char *path) const;
+
+    /**
+     * Get whether this roster has exactly these names in this order
+     * @param names names
+     * @return      true if so
+     */
+    bool has_names(const std::vector<std::string> &names) const;
+
+    /**
+     * Get the rendered names, in order
+     * @return templates
+     */
+    const std::vector<BitView> &get_names() const {
+        return this->names;
+    }
+
+    Roster(const Roster &) = delete;
+    Roster &operator=(const Roster &) = delete;
+    Roster(Roster &&) = default;
+    Roster &operator=(Roster &&) = default;
+    Roster() = default;
+
+private:
+    /** Contents of the file if it was rendered in this process */
+    std::vector<std::byte> owned;
+
+    /** Contents of the file if it was loaded */
+    MappedFile mapped;
+
+    const std::byte *data = nullptr;
+    std::size_t size = 0;
+    const RosterHeader *header = nullptr;
+
+    std::vector<BitView> names;
+
+    /**
+     * Check the contents and point everything into them
+     * @param data contents
+     * @param size size of the contents in bytes
+     * @return     true if the contents are valid
+     */
+    bool bind(const std::byte *data, std::size_t size);
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+#include "roster_index.hpp"
+
+RosterIndex::RosterIndex(const std::vector<BitView> &names) {
+    std::map<std::pair<std::uint32_t, std::uint32_t>, std::size_t> bucket_indices;
+    for(std::size_t n = 0; n < names.size(); n++) {
+        const auto &name = names[n];
+
+        // Empty names never fit anywhere, so they're never candidates
+        if(name.width == 0 || name.height == 0) {
+            continue;
+        }
+
+        auto found = bucket_indices.find({ name.width, name.height });
+        if(found == bucket_indices.end()) {
+            found = bucket_indices.emplace(std::make_pair(name.width, name.height), this->buckets.size()).first;
+            this->buckets.push_back(Bucket { name.width, name.height, {} });
+        }
+
+        std::uint32_t leading_ink = 0;
+        std::uint32_t leading_columns = std::min(LEADING_COLUMNS, name.width);
+        for(std::uint32_t y = 0; y < name.height; y++) {
+            for(std::uint32_t x = 0; x < leading_columns; x++) {
+                leading_ink += name.get(x, y);
+            }
+        }
+
+        this->buckets[found->second].names.push_back(IndexedName { name.ink, leading_ink, n });
+    }
+
+    for(auto &bucket : this->buckets) {
+        std::stable_sort(bucket.names.begin(), bucket.names.end(), [](const IndexedName &a, const IndexedName &b) {
+            return a.ink < b.ink;
+        });
+    }
+}
+
+void RosterIndex::find_candidates(const Matcher &matcher, std::uint32_t x, std::uint32_t y, float minimum_score, std::pmr::vector<RosterCandidate> &candidates) const {
+    candidates.clear();
+
+    auto difference = [](std::uint32_t a, std::uint32_t b) {
+        return a > b ? a - b : b - a;
+    };
+
+    for(auto &bucket : this->buckets) {
+        BitView size;
+        size.width = bucket.width;
+        size.height = bucket.height;
+        if(!matcher.fits(size, x, y)) {
+            continue;
+        }
+
+        std::uint32_t total = bucket.width * bucket.height;
+        std::uint32_t leading_columns = std::min(LEADING_COLUMNS, bucket.width);
+        std::uint32_t leading_total = leading_columns * bucket.height;
+        std::uint32_t window_ink = matcher.ink(x, y, bucket.width, bucket.height);
+        std::uint32_t window_leading_ink = matcher.ink(x, y, leading_columns, bucket.height);
+
+        // Anything that beats the minimum has to be within this much ink of the window. This is loose by a pixel or two
+        // so rounding can't leave anything out; the exact bound is checked below.
+        double minimum_hits = std::floor(static_cast<double>(minimum_score) * total) - 1.0;
+        std::uint32_t tolerance = minimum_hits > 0.0 ? total - static_cast<std::uint32_t>(minimum_hits) : total;
+
+        auto first = std::lower_bound(bucket.names.begin(), bucket.names.end(), window_ink > tolerance ? window_ink - tolerance : 0, [](const IndexedName &name, std::uint32_t ink) {
+            return name.ink < ink;
+        });
+        for(auto n = first; n != bucket.names.end() && n->ink <= window_ink + tolerance; n++) {
+            // Pixels can only match where the leading columns and the rest each agree on ink
+            std::uint32_t hits = leading_total - difference(window_leading_ink, n->leading_ink) + (total - leading_total) - difference(window_ink - window_leading_ink, n->ink - n->leading_ink);
+            float bound = static_cast<float>(hits) / total;
+            if(bound > minimum_score) {
+                candidates.push_back(RosterCandidate { n->name, bound });
+            }
+        }
+    }
+
+    // Keep the roster order so ties go to the same name as matching every name in turn would
+    std::sort(candidates.begin(), candidates.end(), [](const RosterCandidate &a, const RosterCandidate &b) {
+        return a.name < b.name;
+    });
+}
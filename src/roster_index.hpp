@@ -0,0 +1,65 @@
+#ifndef CARNAGE_REPORTER__ROSTER_INDEX_HPP
+#define CARNAGE_REPORTER__ROSTER_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "bit_image.hpp"
+#include "matcher.hpp"
+
+/**
+ * A name that might match at a position, and the best score it could get there
+ */
+struct RosterCandidate {
+    std::size_t name;
+    float bound;
+};
+
+/**
+ * An index of rendered names for ruling most of them out at a position without looking at each one. Names are bucketed
+ * by their size, and each bucket is sorted by ink, so one lookup in the summed-area table per bucket bounds every name
+ * in it. The ink of the leading columns (roughly the first two glyphs) tightens that bound further: pixels can only
+ * match where the window and the name agree on how much ink each part has.
+ */
+class RosterIndex {
+public:
+    /**
+     * Find every name that could score more than a minimum at a position. The bound is never less than what
+     * Matcher::match() returns, so a name that is left out can't score more than the minimum there.
+     * @param matcher       matcher for the screenshot
+     * @param x             left of the name in the image
+     * @param y             top of the name in the image
+     * @param minimum_score score a name has to be able to beat
+     * @param candidates    cleared, then set to the names that could beat it, in roster order
+     */
+    void find_candidates(const Matcher &matcher, std::uint32_t x, std::uint32_t y, float minimum_score, std::pmr::vector<RosterCandidate> &candidates) const;
+
+    /**
+     * Index names
+     * @param names rendered names
+     */
+    RosterIndex(const std::vector<BitView> &names);
+
+private:
+    /** Columns at the left of each name whose ink is indexed separately */
+    static constexpr std::uint32_t LEADING_COLUMNS = 16;
+
+    struct IndexedName {
+        std::uint32_t ink;
+        std::uint32_t leading_ink;
+        std::size_t name;
+    };
+
+    /** Names of one size, sorted by ink */
+    struct Bucket {
+        std::uint32_t width;
+        std::uint32_t height;
+        std::vector<IndexedName> names;
+    };
+
+    std::vector<Bucket> buckets;
+};
+
+#endif
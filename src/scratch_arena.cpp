@@ -0,0 +1,50 @@
+#include <cstdint>
+#include <new>
+
+#include "scratch_arena.hpp"
+
+ScratchArena::ScratchArena(std::size_t capacity) {
+    if(capacity) {
+        this->capacity = (capacity + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+        this->buffer = std::make_unique<std::byte[]>(this->capacity);
+    }
+}
+
+ScratchArena::~ScratchArena() {
+    this->free_overflows();
+}
+
+void ScratchArena::reset() {
+    // Grow to fit everything the last screenshot needed, with room to spare for one a little larger
+    if(!this->overflows.empty()) {
+        std::size_t needed = this->used + this->overflow_size;
+        needed += needed / 4;
+        this->free_overflows();
+        this->buffer.reset();
+        this->capacity = (needed + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+        this->buffer = std::make_unique<std::byte[]>(this->capacity);
+    }
+    this->used = 0;
+}
+
+void ScratchArena::free_overflows() {
+    for(auto &overflow : this->overflows) {
+        ::operator delete(overflow.pointer, std::align_val_t(overflow.alignment));
+    }
+    this->overflows.clear();
+    this->overflow_size = 0;
+}
+
+void *ScratchArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    auto start = reinterpret_cast<std::uintptr_t>(this->buffer.get());
+    std::size_t offset = ((start + this->used + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1)) - start;
+    if(this->buffer && offset <= this->capacity && bytes <= this->capacity - offset) {
+        this->used = offset + bytes;
+        return this->buffer.get() + offset;
+    }
+
+    auto *pointer = ::operator new(bytes, std::align_val_t(alignment));
+    this->overflows.push_back(Overflow { pointer, alignment });
+    this->overflow_size += bytes + alignment;
+    return pointer;
+}
@@ -0,0 +1,67 @@
+#ifndef CARNAGE_REPORTER__SCRATCH_ARENA_HPP
+#define CARNAGE_REPORTER__SCRATCH_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * Memory for everything that only lives while one screenshot is read. Allocating just bumps a pointer, freeing does
+ * nothing, and reset() makes all of it available again at once. Whatever doesn't fit comes from the heap, and the next
+ * reset() grows the arena to fit it, so once an arena has seen a few screenshots, reading more of them allocates nothing
+ * from the heap.
+ */
+class ScratchArena : public std::pmr::memory_resource {
+public:
+    /**
+     * Free everything allocated from the arena, growing it first if it ran out of room since the last reset
+     */
+    void reset();
+
+    /**
+     * Get how much can be allocated before the arena has to fall back to the heap
+     * @return capacity in bytes
+     */
+    std::size_t get_capacity() const {
+        return this->capacity;
+    }
+
+    /**
+     * Create an arena
+     * @param capacity bytes to set aside up front
+     */
+    ScratchArena(std::size_t capacity = 0);
+
+    ScratchArena(const ScratchArena &) = delete;
+    ScratchArena &operator=(const ScratchArena &) = delete;
+    ~ScratchArena() override;
+
+private:
+    /** The arena grows in steps of this many bytes */
+    static constexpr std::size_t GRANULARITY = 64 * 1024;
+
+    std::unique_ptr<std::byte[]> buffer;
+    std::size_t capacity = 0;
+    std::size_t used = 0;
+
+    /** Allocations that didn't fit since the last reset */
+    struct Overflow {
+        void *pointer;
+        std::size_t alignment;
+    };
+    std::vector<Overflow> overflows;
+
+    /** Bytes those allocations took, counting alignment */
+    std::size_t overflow_size = 0;
+
+    void free_overflows();
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+#endif
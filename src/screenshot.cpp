@@ -0,0 +1,213 @@
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "stb/stb_image.h"
+#include "screenshot.hpp"
+#include "error.hpp"
+#include "mapped_file.hpp"
+
+namespace {
+    /**
+     * Per-channel luma contributions, so a pixel's intensity is three lookups and two adds instead of three divisions.
+     * Each channel is rounded on its own in Monochrome, so these add up to exactly the same intensity.
+     */
+    struct LumaTable {
+        std::uint8_t red[256];
+        std::uint8_t green[256];
+        std::uint8_t blue[256];
+
+        LumaTable() {
+            for(unsigned int i = 0; i < 256; i++) {
+                auto value = static_cast<std::uint8_t>(i);
+                this->red[i] = Monochrome(ImagePixel { value, 0, 0, 0 }).intensity;
+                this->green[i] = Monochrome(ImagePixel { 0, value, 0, 0 }).intensity;
+                this->blue[i] = Monochrome(ImagePixel { 0, 0, value, 0 }).intensity;
+            }
+        }
+    };
+
+    /** Where stb_image allocates while this thread decodes a screenshot */
+    thread_local std::pmr::memory_resource *decode_resource = nullptr;
+
+    /** stb_image doesn't say how large a block is when freeing it, so each block starts with its size */
+    constexpr std::size_t BLOCK_HEADER = alignof(std::max_align_t);
+
+    /** Points stb_image at a resource until the end of the scope, even if decoding throws */
+    class DecodeResourceScope {
+    public:
+        explicit DecodeResourceScope(std::pmr::memory_resource *resource) : previous(std::exchange(decode_resource, resource)) {}
+        ~DecodeResourceScope() {
+            decode_resource = this->previous;
+        }
+
+        DecodeResourceScope(const DecodeResourceScope &) = delete;
+        DecodeResourceScope &operator=(const DecodeResourceScope &) = delete;
+
+    private:
+        std::pmr::memory_resource *previous;
+    };
+}
+
+// stb_image is C, so nothing may be thrown through it. An allocation that fails, such as for an image whose header
+// claims enormous dimensions, returns null instead so stb_image fails the decode on its own.
+extern "C" void *carnage_reporter_stbi_malloc(std::size_t size) {
+    auto *resource = decode_resource ? decode_resource : std::pmr::get_default_resource();
+    if(size > SIZE_MAX - BLOCK_HEADER) {
+        return nullptr;
+    }
+
+    std::byte *block;
+    try {
+        block = static_cast<std::byte *>(resource->allocate(size + BLOCK_HEADER, BLOCK_HEADER));
+    }
+    catch(const std::bad_alloc &) {
+        return nullptr;
+    }
+    std::memcpy(block, &size, sizeof(size));
+    return block + BLOCK_HEADER;
+}
+
+extern "C" void carnage_reporter_stbi_free(void *pointer) {
+    if(!pointer) {
+        return;
+    }
+    auto *resource = decode_resource ? decode_resource : std::pmr::get_default_resource();
+    auto *block = static_cast<std::byte *>(pointer) - BLOCK_HEADER;
+    std::size_t size;
+    std::memcpy(&size, block, sizeof(size));
+    resource->deallocate(block, size + BLOCK_HEADER, BLOCK_HEADER);
+}
+
+extern "C" void *carnage_reporter_stbi_realloc(void *pointer, std::size_t size) {
+    auto *resized = carnage_reporter_stbi_malloc(size);
+    if(!resized) {
+        // Like realloc(), leave the old block alone so stb_image can still free it
+        return nullptr;
+    }
+    if(pointer) {
+        std::size_t old_size;
+        std::memcpy(&old_size, static_cast<std::byte *>(pointer) - BLOCK_HEADER, sizeof(old_size));
+        std::memcpy(resized, pointer, old_size < size ? old_size : size);
+        carnage_reporter_stbi_free(pointer);
+    }
+    return resized;
+}
+
+DecodedImage::DecodedImage(std::uint8_t *pixels, std::uint32_t width, std::uint32_t height, std::pmr::memory_resource *resource) : pixels(pixels), width(width), height(height), resource(resource) {}
+
+DecodedImage::DecodedImage(DecodedImage &&other) noexcept {
+    *this = std::move(other);
+}
+
+DecodedImage &DecodedImage::operator=(DecodedImage &&other) noexcept {
+    if(this != &other) {
+        this->~DecodedImage();
+        this->pixels = std::exchange(other.pixels, nullptr);
+        this->width = other.width;
+        this->height = other.height;
+        this->resource = other.resource;
+    }
+    return *this;
+}
+
+DecodedImage::~DecodedImage() {
+    if(this->pixels) {
+        // Free it where it came from, whichever thread this is
+        DecodeResourceScope scope(this->resource);
+        stbi_image_free(this->pixels);
+        this->pixels = nullptr;
+    }
+}
+
+DecodedImage DecodedImage::load(const char *path, std::pmr::memory_resource *resource) {
+    int x = 0, y = 0, channels = 0;
+    stbi_uc *image_buffer;
+    {
+        DecodeResourceScope scope(resource);
+
+        // Decode straight out of the page cache rather than copying the file through stdio. Anything that can't be mapped,
+        // such as a pipe, is still read the usual way. Alpha isn't used, so don't ask for it.
+        MappedFile file;
+        if(file.open(path) && file.size() <= static_cast<std::size_t>(INT_MAX)) {
+            image_buffer = stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(file.data()), static_cast<int>(file.size()), &x, &y, &channels, 3);
+        }
+        else {
+            image_buffer = stbi_load(path, &x, &y, &channels, 3);
+        }
+    }
+    if(!image_buffer) {
+        throw_error(ErrorKind::DECODE_FAILED, "Failed to load %s. Error was: %s", path, stbi_failure_reason());
+    }
+
+    return DecodedImage(image_buffer, static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y), resource);
+}
+
+DecodedImage DecodedImage::decode(const std::byte *data, std::size_t size, std::pmr::memory_resource *resource) {
+    if(size > static_cast<std::size_t>(INT_MAX)) {
+        throw_error(ErrorKind::DECODE_FAILED, "Failed to decode a %zu byte image. Error was: too large", size);
+    }
+
+    int x = 0, y = 0, channels = 0;
+    stbi_uc *image_buffer;
+    {
+        DecodeResourceScope scope(resource);
+        image_buffer = stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(data), static_cast<int>(size), &x, &y, &channels, 3);
+    }
+    if(!image_buffer) {
+        throw_error(ErrorKind::DECODE_FAILED, "Failed to decode a %zu byte image. Error was: %s", size, stbi_failure_reason());
+    }
+
+    return DecodedImage(image_buffer, static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y), resource);
+}
+
+Screenshot load_screenshot(const char *path, std::pmr::memory_resource *resource) {
+    return make_screenshot(DecodedImage::load(path, resource), resource);
+}
+
+Screenshot decode_screenshot(const std::byte *data, std::size_t size, std::pmr::memory_resource *resource) {
+    return make_screenshot(DecodedImage::decode(data, size, resource), resource);
+}
+
+Screenshot make_screenshot(const DecodedImage &image, std::pmr::memory_resource *resource) {
+    return make_screenshot(image.get_pixels(), image.get_width(), image.get_height(), 3, resource);
+}
+
+Screenshot make_screenshot(const std::uint8_t *pixels, std::uint32_t width, std::uint32_t height, std::uint32_t channels, std::pmr::memory_resource *resource) {
+    static const LumaTable luma;
+
+    Screenshot screenshot {
+        BitImage::create(width, height, 1, resource),
+        BitImage::create(width, height, 1, resource),
+        BitImage::create(width, height, 1, resource)
+    };
+
+    // Go straight from the decoded pixels to the bit planes, 64 pixels at a time
+    for(std::uint32_t row = 0; row < height; row++) {
+        const auto *pixel = pixels + static_cast<std::size_t>(row) * width * channels;
+
+        for(std::uint32_t column = 0; column * 64 < width; column++) {
+            std::uint32_t pixels_in_word = width - column * 64 < 64 ? width - column * 64 : 64;
+            std::uint64_t monochrome = 0, bright = 0, red = 0;
+
+            for(std::uint32_t bit = 0; bit < pixels_in_word; bit++, pixel += channels) {
+                std::uint8_t intensity = luma.red[pixel[0]] + luma.green[pixel[1]] + luma.blue[pixel[2]];
+                monochrome |= static_cast<std::uint64_t>(intensity >= MONOCHROME_THRESHOLD) << bit;
+                bright |= static_cast<std::uint64_t>(intensity > 0x7F) << bit;
+                red |= static_cast<std::uint64_t>(pixel[0] > pixel[2]) << bit;
+            }
+
+            std::size_t offset = row + static_cast<std::size_t>(column) * height;
+            screenshot.monochrome.words[offset] = monochrome;
+            screenshot.monochrome.ink += popcount64(monochrome);
+            screenshot.bright.words[offset] = bright;
+            screenshot.bright.ink += popcount64(bright);
+            screenshot.red.words[offset] = red;
+            screenshot.red.ink += popcount64(red);
+        }
+    }
+
+    return screenshot;
+}
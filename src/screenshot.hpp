@@ -0,0 +1,125 @@
+#ifndef CARNAGE_REPORTER__SCREENSHOT_HPP
+#define CARNAGE_REPORTER__SCREENSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+#include "bit_image.hpp"
+
+/**
+ * A screenshot reduced to what is needed to read it. Only a few bits are kept for each pixel rather than its color.
+ * Each plane has a padding column so templates can always read the word to the right of them.
+ */
+struct Screenshot {
+    /** Pixels that pass the monochrome threshold */
+    BitImage monochrome;
+
+    /** Pixels brighter than 0x7F, which are bright enough to tell which team a player is on */
+    BitImage bright;
+
+    /** Pixels with more red than blue */
+    BitImage red;
+};
+
+/**
+ * An image that has been decoded but not yet reduced to a screenshot, for decoding and reducing on different threads
+ */
+class DecodedImage {
+public:
+    /**
+     * Get the pixels
+     * @return pixels, row by row, with three bytes (red, green, and blue) per pixel
+     */
+    const std::uint8_t *get_pixels() const {
+        return this->pixels;
+    }
+
+    /**
+     * Get the width
+     * @return width in pixels
+     */
+    std::uint32_t get_width() const {
+        return this->width;
+    }
+
+    /**
+     * Get the height
+     * @return height in pixels
+     */
+    std::uint32_t get_height() const {
+        return this->height;
+    }
+
+    /**
+     * Decode an image file, throwing a CarnageError if it could not be decoded
+     * @param path     path to the image
+     * @param resource where to allocate the pixels and everything needed to decode them; it must be safe to free them
+     *                 on whatever thread destroys the image
+     * @return         image
+     */
+    static DecodedImage load(const char *path, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    /**
+     * Decode an image file that is already in memory, throwing a CarnageError if it could not be decoded
+     * @param data     contents of the image file
+     * @param size     size of the image file in bytes
+     * @param resource where to allocate the pixels and everything needed to decode them; it must be safe to free them
+     *                 on whatever thread destroys the image
+     * @return         image
+     */
+    static DecodedImage decode(const std::byte *data, std::size_t size, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    DecodedImage(const DecodedImage &) = delete;
+    DecodedImage &operator=(const DecodedImage &) = delete;
+    DecodedImage(DecodedImage &&other) noexcept;
+    DecodedImage &operator=(DecodedImage &&other) noexcept;
+    ~DecodedImage();
+
+private:
+    std::uint8_t *pixels = nullptr;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::pmr::memory_resource *resource = nullptr;
+
+    DecodedImage(std::uint8_t *pixels, std::uint32_t width, std::uint32_t height, std::pmr::memory_resource *resource);
+};
+
+/**
+ * Load a screenshot, throwing a CarnageError if it could not be decoded
+ * @param path     path to the screenshot
+ * @param resource where to allocate the bit planes and everything needed to decode the image
+ * @return         screenshot
+ */
+Screenshot load_screenshot(const char *path, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+/**
+ * Decode a screenshot that is already in memory, such as the contents of a PNG file, throwing a CarnageError if it
+ * could not be decoded
+ * @param data     encoded image
+ * @param size     size of the encoded image in bytes
+ * @param resource where to allocate the bit planes and everything needed to decode the image
+ * @return         screenshot
+ */
+Screenshot decode_screenshot(const std::byte *data, std::size_t size, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+/**
+ * Make a screenshot out of a decoded image
+ * @param image    image
+ * @param resource where to allocate the bit planes
+ * @return         screenshot
+ */
+Screenshot make_screenshot(const DecodedImage &image, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+/**
+ * Make a screenshot out of pixels that are already decoded
+ * @param pixels   pixels, row by row, with red, green, and blue as the first three channels of each
+ * @param width    width in pixels
+ * @param height   height in pixels
+ * @param channels number of channels in each pixel, such as 3 for RGB or 4 for RGBA
+ * @param resource where to allocate the bit planes
+ * @return         screenshot
+ */
+Screenshot make_screenshot(const std::uint8_t *pixels, std::uint32_t width, std::uint32_t height, std::uint32_t channels, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+#endif
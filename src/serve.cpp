@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "serve.hpp"
+#include "job_queue.hpp"
+#include "eprintf.hpp"
+
+namespace {
+    /**
+     * A line read from standard input
+     */
+    struct Request {
+        /** Number of the request, counting from 1 */
+        std::size_t number;
+        std::string line;
+    };
+
+    /**
+     * Recognizers for the names files requests have asked for. They all share the server's compiled font, and only the
+     * most recently used few are kept.
+     */
+    class RosterRecognizers {
+    public:
+        /**
+         * Get a recognizer for a set of names, making one if needed
+         * @param base  the server's recognizer
+         * @param names names to look for
+         * @return      recognizer
+         */
+        std::shared_ptr<const Recognizer> get(const Recognizer &base, const std::vector<std::string> &names) {
+            if(auto found = this->find(names)) {
+                return found;
+            }
+
+            // Render outside of the lock so other requests aren't held up
+            const auto &base_font = base.get_font();
+            auto font = CompiledFont::from_memory(base_font.get_data(), base_font.get_size());
+            auto roster = Roster::render(*font, names);
+            auto recognizer = std::make_shared<const Recognizer>(std::move(*font), std::move(roster), base.get_options());
+
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->entries.push_back(Entry { names, recognizer });
+            if(this->entries.size() > CAPACITY) {
+                this->entries.erase(this->entries.begin());
+            }
+            return recognizer;
+        }
+
+    private:
+        static constexpr std::size_t CAPACITY = 8;
+
+        struct Entry {
+            std::vector<std::string> names;
+            std::shared_ptr<const Recognizer> recognizer;
+        };
+
+        std::mutex mutex;
+
+        /** Least recently used first */
+        std::vector<Entry> entries;
+
+        std::shared_ptr<const Recognizer> find(const std::vector<std::string> &names) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            for(auto entry = this->entries.begin(); entry != this->entries.end(); entry++) {
+                if(entry->names == names) {
+                    auto recognizer = entry->recognizer;
+                    auto moved = std::move(*entry);
+                    this->entries.erase(entry);
+                    this->entries.push_back(std::move(moved));
+                    return recognizer;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    /**
+     * Get the length of the UTF-8 sequence at the start of some text
+     * @param text text
+     * @return     length in bytes, or 0 if it isn't a valid sequence
+     */
+    std::size_t get_utf8_length(std::string_view text) {
+        auto lead = static_cast<unsigned char>(text[0]);
+        std::size_t length;
+        std::uint32_t code_point;
+        if(lead < 0x80) {
+            return 1;
+        }
+        else if(lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+            code_point = lead & 0x1F;
+        }
+        else if(lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            code_point = lead & 0x0F;
+        }
+        else if(lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            code_point = lead & 0x07;
+        }
+        else {
+            return 0;
+        }
+
+        if(text.size() < length) {
+            return 0;
+        }
+        for(std::size_t i = 1; i < length; i++) {
+            auto continuation = static_cast<unsigned char>(text[i]);
+            if((continuation & 0xC0) != 0x80) {
+                return 0;
+            }
+            code_point = (code_point << 6) | (continuation & 0x3F);
+        }
+
+        // Overlong encodings, surrogates, and anything past U+10FFFF aren't allowed
+        if((length == 3 && code_point < 0x800) || (length == 4 && code_point < 0x10000) || (code_point >= 0xD800 && code_point <= 0xDFFF) || code_point > 0x10FFFF) {
+            return 0;
+        }
+        return length;
+    }
+
+    /**
+     * Append text as a JSON string. Paths don't have to be UTF-8, but JSON does, so bytes that aren't part of a valid
+     * sequence are replaced with U+FFFD.
+     * @param json JSON to append to
+     * @param text text
+     */
+    void append_json_string(std::string &json, std::string_view text) {
+        json += '"';
+        while(!text.empty()) {
+            char c = text[0];
+            std::size_t length = 1;
+            switch(c) {
+                case '"':
+                    json += "\\\"";
+                    break;
+                case '\\':
+                    json += "\\\\";
+                    break;
+                case '\n':
+                    json += "\\n";
+                    break;
+                case '\r':
+                    json += "\\r";
+                    break;
+                case '\t':
+                    json += "\\t";
+                    break;
+                default:
+                    if(static_cast<unsigned char>(c) < 0x20) {
+                        char escaped[7];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                        json += escaped;
+                    }
+                    else if((length = get_utf8_length(text)) == 0) {
+                        json += "\\ufffd";
+                        length = 1;
+                    }
+                    else {
+                        json.append(text.data(), length);
+                    }
+                    break;
+            }
+            text.remove_prefix(length);
+        }
+        json += '"';
+    }
+
+    /**
+     * Split a request into its tab-separated fields
+     * @param line request
+     * @return     fields
+     */
+    std::vector<std::string> split_request(const std::string &line) {
+        std::vector<std::string> fields;
+        std::size_t start = 0;
+        while(true) {
+            auto tab = line.find('\t', start);
+            fields.emplace_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+            if(tab == std::string::npos) {
+                return fields;
+            }
+            start = tab + 1;
+        }
+    }
+}
+
+int run_server(const Recognizer &recognizer, std::size_t jobs) {
+    JobQueue<Request> queue;
+    RosterRecognizers rosters;
+
+    // Results are written whole, one line at a time, as soon as each request finishes
+    std::mutex output_mutex;
+    std::size_t failures = 0;
+
+    auto worker = [&]() {
+        ScratchArena arena;
+        std::vector<PlayerStats> players;
+
+        while(auto request = queue.pop()) {
+            auto fields = split_request(request->line);
+            std::string json = "{\"request\":" + std::to_string(request->number);
+            if(fields.size() >= 2) {
+                json += ",\"image\":";
+                append_json_string(json, fields[0]);
+                json += ",\"output\":";
+                append_json_string(json, fields[1]);
+            }
+
+            bool failed = false;
+            auto append_error = [&](const CarnageError &e) {
+                failed = true;
+                json += ",\"status\":\"error\",\"error\":";
+                append_json_string(json, get_error_kind_name(e.get_kind()));
+                json += ",\"message\":";
+                append_json_string(json, e.what());
+
+                if(auto &miss = e.get_header_miss()) {
+                    json += ",\"header\":";
+                    append_json_string(json, miss->header);
+                    json += format_message(",\"best_score\":%f,\"x\":%u,\"y\":%u", miss->best_score, miss->x, miss->y);
+                }
+            };
+            try {
+                if(fields.size() < 2 || fields.size() > 3 || fields[0].empty() || fields[1].empty()) {
+                    throw CarnageError(ErrorKind::BAD_REQUEST, "Expected <image>, <output.csv>, and optionally <names.txt>, separated by tabs");
+                }
+
+                // A names file replaces the server's names for this request
+                std::shared_ptr<const Recognizer> roster_recognizer;
+                if(fields.size() == 3 && !fields[2].empty()) {
+                    std::vector<std::string> names;
+                    if(!read_names_file(fields[2].data(), names)) {
+                        throw CarnageError(ErrorKind::NAMES_UNREADABLE, format_message("Failed to open %s for reading", fields[2].data()));
+                    }
+                    roster_recognizer = rosters.get(recognizer, names);
+                }
+
+                (roster_recognizer ? *roster_recognizer : recognizer).recognize(fields[0].data(), arena, players);
+
+                std::FILE *f = std::fopen(fields[1].data(), "wb");
+                if(!f) {
+                    throw CarnageError(ErrorKind::WRITE_FAILED, format_message("Failed to open %s for writing", fields[1].data()));
+                }
+                write_csv_header(f);
+                write_csv(f, players);
+                std::fclose(f);
+
+                json += ",\"status\":\"ok\",\"players\":" + std::to_string(players.size());
+            }
+            catch(CarnageError &e) {
+                append_error(e);
+            }
+            catch(std::exception &e) {
+                append_error(make_read_error(e));
+            }
+            json += "}\n";
+
+            std::lock_guard<std::mutex> lock(output_mutex);
+            failures += failed;
+            std::fwrite(json.data(), 1, json.size(), stdout);
+            std::fflush(stdout);
+        }
+    };
+
+    if(jobs == 0) {
+        jobs = std::thread::hardware_concurrency();
+    }
+    std::vector<std::thread> threads;
+    for(std::size_t j = 0; j < std::max<std::size_t>(jobs, 1); j++) {
+        threads.emplace_back(worker);
+    }
+
+    // Hand out requests until standard input is closed
+    std::size_t requests = 0;
+    std::string line;
+    while(std::getline(std::cin, line)) {
+        if(!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if(!line.empty()) {
+            queue.push(Request { ++requests, std::move(line) });
+        }
+    }
+    queue.close();
+
+    for(auto &thread : threads) {
+        thread.join();
+    }
+
+    eprintf("Served %zu requests; %zu failed\n", requests, failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,20 @@
+#ifndef CARNAGE_REPORTER__SERVE_HPP
+#define CARNAGE_REPORTER__SERVE_HPP
+
+#include <cstddef>
+
+#include "recognizer.hpp"
+
+/**
+ * Read screenshots for as long as requests keep coming in on standard input. Each line is a request: the path to a
+ * screenshot, the path to write its CSV to, and optionally a names file to use instead of the recognizer's names,
+ * separated by tabs. As each request finishes, in whatever order they finish, one line of JSON is written to standard
+ * output saying how it went.
+ * @param recognizer recognizer, with the names to use for requests that don't give a names file
+ * @param jobs       number of requests to work on at once (0 uses the number of hardware threads)
+ * @return           exit status once standard input is closed and every request has finished, which is nonzero if any
+ *                   request failed
+ */
+int run_server(const Recognizer &recognizer, std::size_t jobs);
+
+#endif
@@ -0,0 +1,71 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "socket_protocol.hpp"
+#include "eprintf.hpp"
+
+/**
+ * Send screenshots to a running carnage-reporter --listen and print the reports
+ */
+int main(int argc, const char **argv) {
+    if(argc < 3) {
+        eprintf("Usage: %s <socket> <image> [image ...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int socket = connect_to_service(argv[1]);
+    if(socket == -1) {
+        eprintf("Failed to connect to %s: %s\n", argv[1], std::strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    // Send everything up front; the replies come back in order
+    std::vector<std::uint8_t> image;
+    std::vector<bool> sent(static_cast<std::size_t>(argc), false);
+    int result = EXIT_SUCCESS;
+    for(int a = 2; a < argc; a++) {
+        if(!read_whole_file(argv[a], image)) {
+            eprintf("Failed to open %s for reading\n", argv[a]);
+            result = EXIT_FAILURE;
+            continue;
+        }
+        if(!send_request(socket, image.data(), image.size())) {
+            eprintf("Failed to send %s: %s\n", argv[a], std::strerror(errno));
+            close(socket);
+            return EXIT_FAILURE;
+        }
+        sent[a] = true;
+    }
+
+    // Print each report with the image it came from, and the error instead for any that couldn't be read
+    ReplyStatus status;
+    std::string text;
+    for(int a = 2; a < argc; a++) {
+        if(!sent[a]) {
+            continue;
+        }
+        if(!receive_reply(socket, status, text)) {
+            eprintf("Connection closed before %s was read\n", argv[a]);
+            close(socket);
+            return EXIT_FAILURE;
+        }
+        if(status == ReplyStatus::OK) {
+            if(argc > 3) {
+                std::printf("%s\n", argv[a]);
+            }
+            std::fwrite(text.data(), 1, text.size(), stdout);
+        }
+        else {
+            eprintf("%s: %s\n", argv[a], text.data());
+            result = EXIT_FAILURE;
+        }
+    }
+
+    close(socket);
+    return result;
+}
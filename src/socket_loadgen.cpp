@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "socket_protocol.hpp"
+#include "eprintf.hpp"
+
+/**
+ * Measure how quickly a running carnage-reporter --listen answers. Each connection sends one screenshot at a time,
+ * cycling through the ones given, and waits for its reply before sending the next.
+ */
+int main(int argc, const char **argv) {
+    std::size_t connection_count = 4;
+    std::size_t request_count = 1000;
+    std::vector<const char *> arguments;
+
+    for(int a = 1; a < argc; a++) {
+        if((std::strcmp(argv[a], "--connections") == 0 || std::strcmp(argv[a], "--requests") == 0) && a + 1 < argc) {
+            auto &count = argv[a][2] == 'c' ? connection_count : request_count;
+            char *end;
+            count = std::strtoul(argv[++a], &end, 10);
+            if(*end || count == 0) {
+                eprintf("Invalid count %s\n", argv[a]);
+                return EXIT_FAILURE;
+            }
+        }
+        else {
+            arguments.push_back(argv[a]);
+        }
+    }
+    if(arguments.size() < 2) {
+        eprintf("Usage: %s [--connections N] [--requests N] <socket> <image> [image ...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::vector<std::uint8_t>> images(arguments.size() - 1);
+    for(std::size_t i = 0; i < images.size(); i++) {
+        if(!read_whole_file(arguments[i + 1], images[i])) {
+            eprintf("Failed to open %s for reading\n", arguments[i + 1]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Requests are handed out one at a time so every connection stays busy until they run out
+    std::atomic<std::size_t> next_request = 0;
+    std::atomic<std::size_t> errors = 0;
+    std::atomic<bool> failed = false;
+    std::vector<std::vector<double>> latencies(connection_count);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t c = 0; c < connection_count; c++) {
+        threads.emplace_back([&, c]() {
+            int socket = connect_to_service(arguments[0]);
+            if(socket == -1) {
+                eprintf("Failed to connect to %s: %s\n", arguments[0], std::strerror(errno));
+                failed = true;
+                return;
+            }
+
+            ReplyStatus status;
+            std::string text;
+            std::size_t request;
+            while(!failed && (request = next_request++) < request_count) {
+                const auto &image = images[request % images.size()];
+                auto sent = std::chrono::steady_clock::now();
+                if(!send_request(socket, image.data(), image.size()) || !receive_reply(socket, status, text)) {
+                    eprintf("Connection to %s failed\n", arguments[0]);
+                    failed = true;
+                    break;
+                }
+                latencies[c].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sent).count());
+                errors += status != ReplyStatus::OK;
+            }
+            close(socket);
+        });
+    }
+    for(auto &thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for(auto &connection_latencies : latencies) {
+        all.insert(all.end(), connection_latencies.begin(), connection_latencies.end());
+    }
+    if(all.empty()) {
+        return EXIT_FAILURE;
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double fraction) {
+        return all[std::min(all.size() - 1, static_cast<std::size_t>(fraction * all.size()))];
+    };
+
+    std::printf("%zu requests over %zu connections in %.3f s (%.1f per second); %zu failed\n", all.size(), connection_count, seconds, all.size() / seconds, errors.load());
+    std::printf("Latency: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n", percentile(0.50), percentile(0.90), percentile(0.99), all.back());
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "socket_protocol.hpp"
+
+void put_frame_size(std::uint8_t *header, std::uint32_t size) {
+    for(std::size_t i = 0; i < FRAME_HEADER_SIZE; i++) {
+        header[i] = static_cast<std::uint8_t>(size >> (i * 8));
+    }
+}
+
+std::uint32_t get_frame_size(const std::uint8_t *header) {
+    std::uint32_t size = 0;
+    for(std::size_t i = 0; i < FRAME_HEADER_SIZE; i++) {
+        size |= static_cast<std::uint32_t>(header[i]) << (i * 8);
+    }
+    return size;
+}
+
+int connect_to_service(const char *path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if(std::strlen(path) >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    std::strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd == -1) {
+        return -1;
+    }
+    if(connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == -1) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+static bool send_all(int socket, const std::uint8_t *data, std::size_t size) {
+    while(size > 0) {
+        auto sent = send(socket, data, size, MSG_NOSIGNAL);
+        if(sent == -1) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+static bool receive_all(int socket, std::uint8_t *data, std::size_t size) {
+    while(size > 0) {
+        auto received = recv(socket, data, size, 0);
+        if(received == -1 && errno == EINTR) {
+            continue;
+        }
+        if(received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+bool send_request(int socket, const std::uint8_t *data, std::size_t size) {
+    if(size > MAX_REQUEST_SIZE) {
+        return false;
+    }
+    std::uint8_t header[FRAME_HEADER_SIZE];
+    put_frame_size(header, static_cast<std::uint32_t>(size));
+    return send_all(socket, header, sizeof(header)) && send_all(socket, data, size);
+}
+
+bool receive_reply(int socket, ReplyStatus &status, std::string &text) {
+    std::uint8_t header[FRAME_HEADER_SIZE + 1];
+    if(!receive_all(socket, header, sizeof(header))) {
+        return false;
+    }
+    std::uint32_t size = get_frame_size(header);
+    if(size == 0) {
+        return false;
+    }
+    status = static_cast<ReplyStatus>(header[FRAME_HEADER_SIZE]);
+    text.resize(size - 1);
+    return receive_all(socket, reinterpret_cast<std::uint8_t *>(text.data()), text.size());
+}
+
+bool read_whole_file(const char *path, std::vector<std::uint8_t> &data) {
+    std::FILE *f = std::fopen(path, "rb");
+    if(!f) {
+        return false;
+    }
+    data.clear();
+    std::uint8_t buffer[65536];
+    std::size_t read;
+    while((read = std::fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    bool failed = std::ferror(f);
+    std::fclose(f);
+    return !failed;
+}
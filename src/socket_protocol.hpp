@@ -0,0 +1,78 @@
+#ifndef CARNAGE_REPORTER__SOCKET_PROTOCOL_HPP
+#define CARNAGE_REPORTER__SOCKET_PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Requests to the socket service are a 32-bit little endian length followed by that many bytes of an encoded
+// screenshot. Replies are a 32-bit little endian length followed by a status byte and then text: the report as CSV if it
+// was read, or the error kind and message on one line if it wasn't. A connection can send any number of requests, and
+// replies come back in the same order.
+
+/** Size of the length before each request and reply */
+constexpr std::size_t FRAME_HEADER_SIZE = 4;
+
+/** Largest screenshot the service accepts */
+constexpr std::uint32_t MAX_REQUEST_SIZE = 64 * 1024 * 1024;
+
+/**
+ * Whether a screenshot sent to the socket service was read
+ */
+enum class ReplyStatus : std::uint8_t {
+    /** The text is the report */
+    OK = 0,
+
+    /** The text is "<error kind>: <message>" */
+    ERROR = 1
+};
+
+/**
+ * Write the length at the start of a request or reply
+ * @param header where to write it
+ * @param size   size of the rest of the request or reply
+ */
+void put_frame_size(std::uint8_t *header, std::uint32_t size);
+
+/**
+ * Read the length at the start of a request or reply
+ * @param header length
+ * @return       size of the rest of the request or reply
+ */
+std::uint32_t get_frame_size(const std::uint8_t *header);
+
+/**
+ * Connect to the socket service
+ * @param path path to the socket
+ * @return     connected socket, or -1 on failure (errno is set)
+ */
+int connect_to_service(const char *path);
+
+/**
+ * Send a screenshot to the socket service, blocking until it is all sent
+ * @param socket connected socket
+ * @param data   encoded screenshot
+ * @param size   size of the screenshot in bytes
+ * @return       true if it was sent
+ */
+bool send_request(int socket, const std::uint8_t *data, std::size_t size);
+
+/**
+ * Receive the reply to the oldest request not yet replied to, blocking until it all arrives
+ * @param socket connected socket
+ * @param status set to whether the screenshot was read
+ * @param text   set to the report or the error
+ * @return       true if a reply was received, or false if the connection was closed or failed
+ */
+bool receive_reply(int socket, ReplyStatus &status, std::string &text);
+
+/**
+ * Read a file into memory
+ * @param path path to the file
+ * @param data set to the contents of the file
+ * @return     true if it was read
+ */
+bool read_whole_file(const char *path, std::vector<std::uint8_t> &data);
+
+#endif
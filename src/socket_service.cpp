@@ -0,0 +1,502 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "socket_service.hpp"
+#include "socket_protocol.hpp"
+#include "job_queue.hpp"
+#include "eprintf.hpp"
+
+namespace {
+    /** epoll keys that aren't connections; connections are numbered after these */
+    enum : std::uint64_t {
+        LISTENER_KEY,
+        COMPLETION_KEY,
+        SIGNAL_KEY,
+        FIRST_CONNECTION_KEY
+    };
+
+    /** Most bytes to ask for each time a connection is read from */
+    constexpr std::size_t RECEIVE_SIZE = 64 * 1024;
+
+    /**
+     * Most bytes of requests that can be received but not yet handed to a worker, across every connection. A request
+     * isn't read past its length until there's room for all of it, so this is never exceeded however many clients
+     * connect, and it's at least the largest request so any one request can always be received.
+     */
+    constexpr std::size_t MAX_BUFFERED_INPUT = 4 * static_cast<std::size_t>(MAX_REQUEST_SIZE);
+
+    struct Job {
+        std::uint64_t connection;
+        std::vector<std::byte> image;
+    };
+
+    struct Reply {
+        std::uint64_t connection;
+        std::vector<std::uint8_t> frame;
+    };
+
+    struct Connection {
+        int fd;
+
+        /** Received bytes not yet handed to a worker; never more than one request */
+        std::vector<std::uint8_t> input;
+
+        /** Bytes set aside for the request being received, once its length is known */
+        std::size_t reserved = 0;
+
+        /** The request being received doesn't fit in what's left of the input limit yet */
+        bool starved = false;
+
+        /** Replies not yet sent */
+        std::vector<std::uint8_t> output;
+        std::size_t output_sent = 0;
+
+        /** A request from this connection is queued or being read; replies go out in order, so it's one at a time */
+        bool busy = false;
+
+        /** A whole request is waiting for room in the queue */
+        bool waiting = false;
+
+        /** The client is done sending; close once everything it sent is answered */
+        bool closing = false;
+
+        /** Events epoll is waiting for */
+        std::uint32_t events = 0;
+    };
+
+    /**
+     * Build a reply frame
+     * @param status whether the screenshot was read
+     * @param text   report or error
+     * @return       frame
+     */
+    std::vector<std::uint8_t> make_reply(ReplyStatus status, const std::string &text) {
+        std::vector<std::uint8_t> frame(FRAME_HEADER_SIZE + 1 + text.size());
+        put_frame_size(frame.data(), static_cast<std::uint32_t>(1 + text.size()));
+        frame[FRAME_HEADER_SIZE] = static_cast<std::uint8_t>(status);
+        std::memcpy(frame.data() + FRAME_HEADER_SIZE + 1, text.data(), text.size());
+        return frame;
+    }
+
+    /**
+     * Write a report as CSV, the same as it would be written to a file
+     * @param players players
+     * @return        CSV
+     */
+    std::string format_csv(const std::vector<PlayerStats> &players) {
+        char *buffer = nullptr;
+        std::size_t size = 0;
+        std::FILE *f = open_memstream(&buffer, &size);
+        if(!f) {
+            throw_error(ErrorKind::WRITE_FAILED, "Failed to write the report: %s", std::strerror(errno));
+        }
+        write_csv_header(f);
+        write_csv(f, players);
+        std::fclose(f);
+        std::string csv(buffer, size);
+        std::free(buffer);
+        return csv;
+    }
+
+    /**
+     * Get whether a connection has received at least one whole request
+     * @param connection connection
+     * @return           true if so
+     */
+    bool has_request(const Connection &connection) {
+        if(connection.input.size() < FRAME_HEADER_SIZE) {
+            return false;
+        }
+        return connection.input.size() - FRAME_HEADER_SIZE >= get_frame_size(connection.input.data());
+    }
+
+    /**
+     * Open a listening socket, replacing a stale socket left at the path
+     * @param path path to the socket
+     * @return     socket, or -1 on failure (after saying why)
+     */
+    int listen_at(const char *path) {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if(std::strlen(path) >= sizeof(address.sun_path)) {
+            eprintf("Socket path %s is too long\n", path);
+            return -1;
+        }
+        std::strcpy(address.sun_path, path);
+
+        // Only ever remove a socket, never a file someone mistyped
+        struct stat path_stat;
+        if(stat(path, &path_stat) == 0 && S_ISSOCK(path_stat.st_mode)) {
+            unlink(path);
+        }
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(fd == -1 || bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == -1 || listen(fd, SOMAXCONN) == -1) {
+            eprintf("Failed to listen on %s: %s\n", path, std::strerror(errno));
+            if(fd != -1) {
+                close(fd);
+            }
+            return -1;
+        }
+        return fd;
+    }
+}
+
+int run_socket_service(const Recognizer &recognizer, const char *path, std::size_t jobs, std::size_t queue_depth) {
+    if(jobs == 0) {
+        jobs = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    if(queue_depth == 0) {
+        queue_depth = jobs * 4;
+    }
+
+    // Interrupting or terminating the service stops it cleanly; block the signals before any worker starts so only the
+    // event loop sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    int listener = listen_at(path);
+    if(listener == -1) {
+        return EXIT_FAILURE;
+    }
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    int completion_event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int signal_event = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if(epoll == -1 || completion_event == -1 || signal_event == -1) {
+        eprintf("Failed to start the event loop: %s\n", std::strerror(errno));
+        for(int fd : { signal_event, completion_event, epoll }) {
+            if(fd != -1) {
+                close(fd);
+            }
+        }
+        close(listener);
+        unlink(path);
+        return EXIT_FAILURE;
+    }
+    auto watch = [&epoll](int fd, std::uint64_t key, std::uint32_t events, int operation) {
+        epoll_event event = {};
+        event.events = events;
+        event.data.u64 = key;
+        epoll_ctl(epoll, operation, fd, &event);
+    };
+    watch(listener, LISTENER_KEY, EPOLLIN, EPOLL_CTL_ADD);
+    watch(completion_event, COMPLETION_KEY, EPOLLIN, EPOLL_CTL_ADD);
+    watch(signal_event, SIGNAL_KEY, EPOLLIN, EPOLL_CTL_ADD);
+
+    // Workers read screenshots and leave the replies for the event loop to send
+    JobQueue<Job> queue;
+    std::mutex completed_mutex;
+    std::vector<Reply> completed;
+    std::vector<std::thread> workers;
+    for(std::size_t j = 0; j < jobs; j++) {
+        workers.emplace_back([&]() {
+            ScratchArena arena;
+            std::vector<PlayerStats> players;
+            while(auto job = queue.pop()) {
+                Reply reply { job->connection, {} };
+                try {
+                    recognizer.recognize(job->image.data(), job->image.size(), arena, players);
+                    reply.frame = make_reply(ReplyStatus::OK, format_csv(players));
+                }
+                catch(CarnageError &e) {
+                    reply.frame = make_reply(ReplyStatus::ERROR, std::string(get_error_kind_name(e.get_kind())) + ": " + e.what());
+                }
+                catch(std::exception &e) {
+                    auto error = make_read_error(e);
+                    reply.frame = make_reply(ReplyStatus::ERROR, std::string(get_error_kind_name(error.get_kind())) + ": " + error.what());
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(completed_mutex);
+                    completed.push_back(std::move(reply));
+                }
+                std::uint64_t one = 1;
+                auto written = write(completion_event, &one, sizeof(one));
+                (void)written;
+            }
+        });
+    }
+
+    std::unordered_map<std::uint64_t, Connection> connections;
+    std::uint64_t next_key = FIRST_CONNECTION_KEY;
+
+    // Requests queued or being read, and connections waiting for that to drop below the queue depth
+    std::size_t outstanding = 0;
+    std::deque<std::uint64_t> waiting;
+
+    // Bytes set aside for requests being received, and connections waiting for room to receive theirs, first come first
+    // served so a large request isn't passed over forever
+    std::size_t buffered = 0;
+    std::deque<std::uint64_t> starved;
+
+    std::size_t served = 0;
+    std::size_t failures = 0;
+
+    auto close_connection = [&](std::uint64_t key) {
+        auto &connection = connections.at(key);
+        buffered -= connection.reserved;
+        close(connection.fd);
+        connections.erase(key);
+    };
+
+    // Set aside room for the rest of the request whose length has arrived, or wait in line for it. Returns false if the
+    // connection has to wait.
+    auto reserve = [&](std::uint64_t key, Connection &connection) {
+        if(connection.reserved || connection.starved) {
+            return connection.reserved != 0;
+        }
+        std::size_t size = get_frame_size(connection.input.data());
+        if(!starved.empty() || size > MAX_BUFFERED_INPUT - buffered) {
+            connection.starved = true;
+            starved.push_back(key);
+            return false;
+        }
+        connection.reserved = std::max<std::size_t>(size, 1);
+        buffered += connection.reserved;
+        return true;
+    };
+
+    // Hand the connection's next request to a worker if it has one and there is room
+    auto dispatch = [&](std::uint64_t key, Connection &connection) {
+        if(connection.busy || connection.waiting || connection.input.size() < FRAME_HEADER_SIZE) {
+            return;
+        }
+
+        // Don't buffer something this large; say why and hang up
+        std::uint32_t size = get_frame_size(connection.input.data());
+        if(size > MAX_REQUEST_SIZE) {
+            auto frame = make_reply(ReplyStatus::ERROR, format_message("%s: Requests can't be larger than %u bytes", get_error_kind_name(ErrorKind::BAD_REQUEST), MAX_REQUEST_SIZE));
+            connection.output.insert(connection.output.end(), frame.begin(), frame.end());
+            connection.input.clear();
+            connection.closing = true;
+            return;
+        }
+        if(!has_request(connection)) {
+            return;
+        }
+        if(outstanding >= queue_depth) {
+            connection.waiting = true;
+            waiting.push_back(key);
+            return;
+        }
+
+        auto *image = reinterpret_cast<const std::byte *>(connection.input.data() + FRAME_HEADER_SIZE);
+        queue.push(Job { key, std::vector<std::byte>(image, image + size) });
+        connection.input.clear();
+        connection.busy = true;
+        outstanding++;
+        buffered -= connection.reserved;
+        connection.reserved = 0;
+    };
+
+    // Send what can be sent without blocking, then wait for whatever the connection needs next. Returns false if the
+    // connection was closed.
+    auto update = [&](std::uint64_t key, Connection &connection) {
+        while(connection.output_sent < connection.output.size()) {
+            auto sent = send(connection.fd, connection.output.data() + connection.output_sent, connection.output.size() - connection.output_sent, MSG_NOSIGNAL);
+            if(sent == -1) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                close_connection(key);
+                return false;
+            }
+            connection.output_sent += static_cast<std::size_t>(sent);
+        }
+        if(connection.output_sent == connection.output.size()) {
+            connection.output.clear();
+            connection.output_sent = 0;
+        }
+
+        bool pending = connection.busy || connection.waiting || has_request(connection);
+        if(connection.closing && !pending && connection.output.empty()) {
+            close_connection(key);
+            return false;
+        }
+
+        // Stop reading once a whole request is waiting, so a client can't queue up more than one, or while there's no room
+        // for the rest of the request
+        std::uint32_t events = (connection.closing || connection.starved || has_request(connection) ? 0 : static_cast<std::uint32_t>(EPOLLIN)) | (connection.output.empty() ? 0 : static_cast<std::uint32_t>(EPOLLOUT));
+        if(events != connection.events) {
+            watch(connection.fd, key, events, EPOLL_CTL_MOD);
+            connection.events = events;
+        }
+        return true;
+    };
+
+    bool running = true;
+    std::vector<std::uint8_t> receive_buffer(RECEIVE_SIZE);
+    epoll_event events[64];
+    while(running) {
+        int event_count = epoll_wait(epoll, events, sizeof(events) / sizeof(*events), -1);
+        if(event_count == -1) {
+            if(errno == EINTR) {
+                continue;
+            }
+            eprintf("Failed to wait for events: %s\n", std::strerror(errno));
+            break;
+        }
+
+        for(int e = 0; e < event_count; e++) {
+            auto key = events[e].data.u64;
+
+            if(key == SIGNAL_KEY) {
+                running = false;
+            }
+
+            else if(key == LISTENER_KEY) {
+                int fd;
+                while((fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+                    auto &connection = connections[next_key];
+                    connection.fd = fd;
+                    connection.events = EPOLLIN;
+                    watch(fd, next_key, EPOLLIN, EPOLL_CTL_ADD);
+                    next_key++;
+                }
+            }
+
+            else if(key == COMPLETION_KEY) {
+                std::uint64_t count;
+                auto read_count = read(completion_event, &count, sizeof(count));
+                (void)read_count;
+
+                std::vector<Reply> replies;
+                {
+                    std::lock_guard<std::mutex> lock(completed_mutex);
+                    replies.swap(completed);
+                }
+
+                for(auto &reply : replies) {
+                    outstanding--;
+                    served++;
+                    failures += reply.frame[FRAME_HEADER_SIZE] != static_cast<std::uint8_t>(ReplyStatus::OK);
+
+                    // The client may have gone away in the meantime
+                    auto found = connections.find(reply.connection);
+                    if(found == connections.end()) {
+                        continue;
+                    }
+                    auto &connection = found->second;
+                    connection.output.insert(connection.output.end(), reply.frame.begin(), reply.frame.end());
+                    connection.busy = false;
+                    dispatch(reply.connection, connection);
+                    update(reply.connection, connection);
+                }
+
+                // Make room for connections that were held back
+                while(outstanding < queue_depth && !waiting.empty()) {
+                    auto waiting_key = waiting.front();
+                    waiting.pop_front();
+                    auto found = connections.find(waiting_key);
+                    if(found == connections.end()) {
+                        continue;
+                    }
+                    found->second.waiting = false;
+                    dispatch(waiting_key, found->second);
+                    update(waiting_key, found->second);
+                }
+            }
+
+            else {
+                auto found = connections.find(key);
+                if(found == connections.end()) {
+                    continue;
+                }
+                auto &connection = found->second;
+
+                if(events[e].events & (EPOLLERR | EPOLLHUP)) {
+                    close_connection(key);
+                    continue;
+                }
+
+                if(events[e].events & EPOLLIN) {
+                    // Read the length first, then no more than the rest of the request once there's room for it
+                    while(!has_request(connection)) {
+                        std::size_t wanted;
+                        if(connection.input.size() < FRAME_HEADER_SIZE) {
+                            wanted = FRAME_HEADER_SIZE - connection.input.size();
+                        }
+                        else if(get_frame_size(connection.input.data()) > MAX_REQUEST_SIZE || !reserve(key, connection)) {
+                            break;
+                        }
+                        else {
+                            wanted = std::min(RECEIVE_SIZE, FRAME_HEADER_SIZE + get_frame_size(connection.input.data()) - connection.input.size());
+                        }
+
+                        auto received = recv(connection.fd, receive_buffer.data(), wanted, 0);
+                        if(received > 0) {
+                            connection.input.insert(connection.input.end(), receive_buffer.begin(), receive_buffer.begin() + received);
+                            continue;
+                        }
+                        if(received == -1 && errno == EINTR) {
+                            continue;
+                        }
+                        if(received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                            connection.closing = true;
+                        }
+                        break;
+                    }
+                    dispatch(key, connection);
+                }
+                update(key, connection);
+            }
+        }
+
+        // Let connections that were waiting for room go on receiving, in the order they started waiting
+        while(!starved.empty()) {
+            auto found = connections.find(starved.front());
+            if(found != connections.end()) {
+                auto &connection = found->second;
+                std::size_t size = std::max<std::size_t>(get_frame_size(connection.input.data()), 1);
+                if(size > MAX_BUFFERED_INPUT - buffered) {
+                    break;
+                }
+                connection.starved = false;
+                connection.reserved = size;
+                buffered += size;
+                update(found->first, connection);
+            }
+            starved.pop_front();
+        }
+    }
+
+    // Finish what was already taken, but don't send it anywhere
+    close(listener);
+    unlink(path);
+    queue.close();
+    for(auto &worker : workers) {
+        worker.join();
+    }
+    for(auto &connection : connections) {
+        close(connection.second.fd);
+    }
+    close(signal_event);
+    close(completion_event);
+    close(epoll);
+
+    eprintf("Served %zu requests; %zu failed\n", served, failures);
+    return EXIT_SUCCESS;
+}
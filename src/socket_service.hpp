@@ -0,0 +1,23 @@
+#ifndef CARNAGE_REPORTER__SOCKET_SERVICE_HPP
+#define CARNAGE_REPORTER__SOCKET_SERVICE_HPP
+
+#include <cstddef>
+
+#include "recognizer.hpp"
+
+/**
+ * Read screenshots sent to a Unix domain socket until the program is interrupted or terminated. One thread waits on
+ * every connection and hands complete requests to a pool of workers (see socket_protocol.hpp for what is sent). Once
+ * queue_depth requests are waiting or being read, no more are taken until one finishes, and connections that have sent
+ * a whole request stop being read from. Requests that are still arriving are only read once there's room for all of
+ * them under a fixed limit shared by every connection. Clients that send faster than screenshots can be read are held
+ * back by their sockets filling up instead of by the service running out of memory, however many of them connect.
+ * @param recognizer  recognizer
+ * @param path        path to create the socket at; a socket already there is replaced
+ * @param jobs        number of screenshots to read at once (0 uses the number of hardware threads)
+ * @param queue_depth most requests to hold at once, counting the ones being read (0 uses four per job)
+ * @return            exit status
+ */
+int run_socket_service(const Recognizer &recognizer, const char *path, std::size_t jobs, std::size_t queue_depth);
+
+#endif
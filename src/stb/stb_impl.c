@@ -1,3 +1,13 @@
+#include <stddef.h>
+
+// Decoding allocates from the memory resource the screenshot is loaded with (see screenshot.cpp)
+void *carnage_reporter_stbi_malloc(size_t size);
+void *carnage_reporter_stbi_realloc(void *pointer, size_t size);
+void carnage_reporter_stbi_free(void *pointer);
+#define STBI_MALLOC(size) carnage_reporter_stbi_malloc(size)
+#define STBI_REALLOC(pointer, size) carnage_reporter_stbi_realloc(pointer, size)
+#define STBI_FREE(pointer) carnage_reporter_stbi_free(pointer)
+
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_NO_PSD
 #define STBI_NO_GIF
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "tar_reader.hpp"
+#include "error.hpp"
+
+namespace {
+    /**
+     * Read a number from a header field, which is octal text unless the top bit is set (then it's big endian binary)
+     */
+    bool parse_number(const std::uint8_t *field, std::size_t length, std::uint64_t &number) {
+        number = 0;
+        if(field[0] & 0x80) {
+            for(std::size_t i = 0; i < length; i++) {
+                number = (number << 8) | (i == 0 ? field[i] & 0x7F : field[i]);
+            }
+            return true;
+        }
+
+        std::size_t i = 0;
+        while(i < length && field[i] == ' ') {
+            i++;
+        }
+        bool digits = false;
+        for(; i < length && field[i] >= '0' && field[i] <= '7'; i++) {
+            number = number * 8 + (field[i] - '0');
+            digits = true;
+        }
+        return digits;
+    }
+
+    std::string get_field(const std::uint8_t *field, std::size_t length) {
+        auto *text = reinterpret_cast<const char *>(field);
+        return std::string(text, strnlen(text, length));
+    }
+
+    /**
+     * Get the path out of pax extended header records ("<length> <key>=<value>\n")
+     */
+    std::string get_pax_path(const std::string &records) {
+        std::string path;
+        std::size_t offset = 0;
+        while(offset < records.size()) {
+            auto space = records.find(' ', offset);
+            if(space == std::string::npos) {
+                break;
+            }
+            std::size_t length = std::strtoul(records.data() + offset, nullptr, 10);
+            if(length <= space - offset || offset + length > records.size()) {
+                break;
+            }
+            auto record = records.substr(space + 1, offset + length - space - 2);
+            if(record.compare(0, 5, "path=") == 0) {
+                path = record.substr(5);
+            }
+            offset += length;
+        }
+        return path;
+    }
+}
+
+TarReader::TarReader(std::FILE *input) : input(input) {}
+
+void TarReader::read_bytes(void *data, std::size_t size) {
+    if(std::fread(data, 1, size, this->input) != size) {
+        throw_error(ErrorKind::ARCHIVE_UNREADABLE, "The archive ends partway through a file");
+    }
+}
+
+void TarReader::skip(std::uint64_t size) {
+    std::uint8_t buffer[BLOCK_SIZE * 16];
+    while(size > 0) {
+        auto length = static_cast<std::size_t>(std::min<std::uint64_t>(size, sizeof(buffer)));
+        this->read_bytes(buffer, length);
+        size -= length;
+    }
+}
+
+bool TarReader::next(std::string &name, std::uint64_t &size) {
+    this->skip(this->remaining + this->padding);
+    this->remaining = 0;
+    this->padding = 0;
+
+    // A GNU long name or pax path applies to the entry right after it
+    std::string long_name;
+
+    while(true) {
+        std::uint8_t header[BLOCK_SIZE];
+        std::size_t read = std::fread(header, 1, sizeof(header), this->input);
+        if(read == 0 && !std::ferror(this->input)) {
+            return false;
+        }
+        if(read != sizeof(header)) {
+            throw_error(ErrorKind::ARCHIVE_UNREADABLE, "The archive ends partway through a header");
+        }
+
+        // The archive ends with blocks of zeros
+        bool empty = true;
+        std::uint32_t checksum = 0;
+        for(std::size_t i = 0; i < sizeof(header); i++) {
+            empty = empty && header[i] == 0;
+            checksum += (i >= 148 && i < 156) ? ' ' : header[i];
+        }
+        if(empty) {
+            return false;
+        }
+
+        std::uint64_t expected_checksum, entry_size;
+        if(!parse_number(header + 148, 8, expected_checksum) || expected_checksum != checksum) {
+            throw_error(ErrorKind::ARCHIVE_UNREADABLE, "This isn't an uncompressed tar archive, or it's corrupt");
+        }
+        if(!parse_number(header + 124, 12, entry_size)) {
+            entry_size = 0;
+        }
+        std::uint64_t entry_padding = (BLOCK_SIZE - entry_size % BLOCK_SIZE) % BLOCK_SIZE;
+
+        char type = static_cast<char>(header[156]);
+        if(type == 'L' || type == 'x') {
+            if(entry_size > MAX_NAME_RECORD_SIZE) {
+                throw_error(ErrorKind::ARCHIVE_UNREADABLE, "A file name in the archive is %" PRIu64 " bytes long, so the archive is probably corrupt", entry_size);
+            }
+            std::string text(static_cast<std::size_t>(entry_size), '\0');
+            this->read_bytes(text.data(), text.size());
+            this->skip(entry_padding);
+            long_name = type == 'L' ? get_field(reinterpret_cast<const std::uint8_t *>(text.data()), text.size()) : get_pax_path(text);
+            continue;
+        }
+
+        // Only regular files have contents worth reading
+        if(type != '0' && type != '\0' && type != '7') {
+            this->skip(entry_size + entry_padding);
+            long_name.clear();
+            continue;
+        }
+
+        if(!long_name.empty()) {
+            name = std::move(long_name);
+        }
+        else {
+            name = get_field(header, 100);
+            if(std::memcmp(header + 257, "ustar", 5) == 0 && header[345] != 0) {
+                name = get_field(header + 345, 155) + "/" + name;
+            }
+        }
+        size = entry_size;
+        this->remaining = entry_size;
+        this->padding = entry_padding;
+        return true;
+    }
+}
+
+void TarReader::read(std::byte *data) {
+    auto size = static_cast<std::size_t>(this->remaining);
+    this->read_bytes(data, size);
+    this->remaining = 0;
+}
@@ -0,0 +1,52 @@
+#ifndef CARNAGE_REPORTER__TAR_READER_HPP
+#define CARNAGE_REPORTER__TAR_READER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/**
+ * Reads the files in a tar archive one after another as the archive streams past, so it can come from a pipe and never
+ * has to be unpacked. Understands ustar, GNU long names, and pax paths; anything that isn't a regular file is skipped.
+ * Archives that are truncated or aren't tar archives at all throw a CarnageError.
+ */
+class TarReader {
+public:
+    /**
+     * Go to the next file, skipping whatever is left of the current one
+     * @param name set to the path of the file in the archive
+     * @param size set to the size of the file in bytes
+     * @return     true if there was another file, or false at the end of the archive
+     */
+    bool next(std::string &name, std::uint64_t &size);
+
+    /**
+     * Read the contents of the file next() went to. This can only be done once per file.
+     * @param data where to read it; must hold the size next() gave
+     */
+    void read(std::byte *data);
+
+    /**
+     * Read an archive
+     * @param input archive, which is read from its current position and left open
+     */
+    TarReader(std::FILE *input);
+
+private:
+    static constexpr std::size_t BLOCK_SIZE = 512;
+
+    /** GNU long names and pax headers are read whole, so anything claiming to be larger than this is taken as corrupt */
+    static constexpr std::uint64_t MAX_NAME_RECORD_SIZE = 1024 * 1024;
+
+    std::FILE *input;
+
+    /** Bytes left of the current file, and the padding after them */
+    std::uint64_t remaining = 0;
+    std::uint64_t padding = 0;
+
+    void read_bytes(void *data, std::size_t size);
+    void skip(std::uint64_t size);
+};
+
+#endif
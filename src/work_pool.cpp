@@ -0,0 +1,88 @@
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "work_pool.hpp"
+
+namespace {
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::size_t> jobs;
+
+        std::optional<std::size_t> pop_front() {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if(this->jobs.empty()) {
+                return std::nullopt;
+            }
+            auto job = this->jobs.front();
+            this->jobs.pop_front();
+            return job;
+        }
+
+        std::optional<std::size_t> steal_back() {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if(this->jobs.empty()) {
+                return std::nullopt;
+            }
+            auto job = this->jobs.back();
+            this->jobs.pop_back();
+            return job;
+        }
+    };
+}
+
+void run_work_stealing(std::size_t job_count, std::size_t thread_count, const std::function<void (std::size_t job, std::size_t worker)> &job) {
+    if(thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+    }
+    if(thread_count > job_count) {
+        thread_count = job_count;
+    }
+    if(thread_count <= 1) {
+        for(std::size_t j = 0; j < job_count; j++) {
+            job(j, 0);
+        }
+        return;
+    }
+
+    // Deal out the jobs in contiguous blocks so neighboring jobs start on the same worker
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    for(std::size_t w = 0; w < thread_count; w++) {
+        auto &queue = queues.emplace_back(std::make_unique<WorkQueue>());
+        std::size_t first = job_count * w / thread_count;
+        std::size_t last = job_count * (w + 1) / thread_count;
+        for(std::size_t j = first; j < last; j++) {
+            queue->jobs.push_back(j);
+        }
+    }
+
+    auto worker = [&queues, &job, thread_count](std::size_t w) {
+        while(true) {
+            auto next = queues[w]->pop_front();
+
+            // Out of work? Go through everyone else until we find something to steal
+            for(std::size_t v = 1; !next.has_value() && v < thread_count; v++) {
+                next = queues[(w + v) % thread_count]->steal_back();
+            }
+
+            // Nothing left anywhere
+            if(!next.has_value()) {
+                return;
+            }
+
+            job(next.value(), w);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(std::size_t w = 1; w < thread_count; w++) {
+        threads.emplace_back(worker, w);
+    }
+    worker(0);
+    for(auto &t : threads) {
+        t.join();
+    }
+}
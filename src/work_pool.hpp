@@ -0,0 +1,16 @@
+#ifndef CARNAGE_REPORTER__WORK_POOL_HPP
+#define CARNAGE_REPORTER__WORK_POOL_HPP
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * Run jobs 0 through job_count - 1 on a pool of threads. Each worker starts with its own contiguous share of the jobs
+ * and, once it runs out, steals jobs from the back of the other workers' queues.
+ * @param job_count    number of jobs
+ * @param thread_count number of worker threads (0 uses the number of hardware threads)
+ * @param job          function called with the job index and the worker index
+ */
+void run_work_stealing(std::size_t job_count, std::size_t thread_count, const std::function<void (std::size_t job, std::size_t worker)> &job);
+
+#endif
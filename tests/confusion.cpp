@@ -0,0 +1,115 @@
+#include <string>
+#include <vector>
+
+#include "synthetic.hpp"
+#include "recognizer.hpp"
+
+// Names that use every glyph of the seed pairs next to each other and next to other glyphs
+static const char *NAMES[] = { "lilI2Zaenm", "mill Inn", "Zeal2", "nmnmn", "Iil leel", "amen2Z", "manna", "ZZ2a2e" };
+
+/**
+ * Fix a string the way the recognizer used to: for each glyph of each seed pair, render the whole string with either
+ * glyph and keep whichever matches better, with the second glyph winning ties
+ * @param font  font
+ * @param image image being read
+ * @param text  string that was read
+ * @param x     left of the string
+ * @param y     top of the string
+ * @return      fixed string
+ */
+static std::string fix_errors(const CompiledFont &font, const BitImage &image, std::string text, std::uint32_t x, std::uint32_t y) {
+    for(std::size_t i = 0; i < text.size(); i++) {
+        for(auto &pair : ConfusionTable::SEED_PAIRS) {
+            char &output = text[i];
+            if(output != pair[0] && output != pair[1]) {
+                continue;
+            }
+
+            output = pair[0];
+            float match_a = match(image, font.draw(text.c_str()), x, y);
+            output = pair[1];
+            float match_b = match(image, font.draw(text.c_str()), x, y);
+            output = match_a > match_b ? pair[0] : pair[1];
+        }
+    }
+    return text;
+}
+
+int main() {
+    auto font = make_synthetic_font();
+    auto compiled = CompiledFont::compile(font);
+    TestFailures failures;
+
+    std::vector<SyntheticRow> rows;
+    for(auto *name : NAMES) {
+        rows.push_back(SyntheticRow { name, rows.size() % 2 == 0, 1, 2, 3, 4 });
+    }
+
+    // Every glyph of the seed pairs, read as the other glyph of its pair, has to be put back by the confusion table
+    // whenever the old fixes would have put it back, and always when there's no noise. The old fixes themselves can't
+    // always do that, since they went through the pairs in order and compared whole strings with the misread glyph in
+    // them.
+    ConfusionTable table(compiled.get_characters());
+    for(double noise : { 0.0, 0.01, 0.03 }) {
+        auto drawn = make_synthetic_screenshot(font, rows, 3, noise);
+        auto screenshot = make_screenshot(drawn.pixels.data(), drawn.width, drawn.height, 4);
+
+        for(std::size_t r = 0; r < rows.size(); r++) {
+            const auto &name = rows[r].name;
+            std::uint32_t y = drawn.name_y + static_cast<std::uint32_t>(r) * SYNTHETIC_ROW_HEIGHT;
+            for(std::size_t i = 0; i < name.size(); i++) {
+                std::uint32_t x = drawn.name_x + compiled.draw(name.substr(0, i).c_str()).width;
+                for(auto &pair : ConfusionTable::SEED_PAIRS) {
+                    for(int side = 0; side < 2; side++) {
+                        if(name[i] != pair[side]) {
+                            continue;
+                        }
+
+                        auto misread = name;
+                        misread[i] = pair[1 - side];
+                        auto fixed = fix_errors(compiled, screenshot.monochrome, misread, drawn.name_x, y);
+                        char disambiguated = table.disambiguate(screenshot.monochrome, misread[i], x, y);
+                        if(disambiguated != name[i] && (fixed == name || noise == 0.0)) {
+                            failures.add("noise=%g: \"%s\" misread as \"%s\" was fixed to \"%s\" by the old fixes but '%c' by the table\n", noise, name.c_str(), misread.c_str(), fixed.c_str(), disambiguated);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Whole screenshots read the same as they were drawn, which the old fixes leave alone
+    for(bool dp_decoding : { false, true }) {
+        RecognizerOptions options;
+        options.dp_decoding = dp_decoding;
+        Recognizer recognizer(font, {}, options);
+
+        for(double noise : { 0.0, 0.01, 0.03 }) {
+            auto drawn = make_synthetic_screenshot(font, rows, 2, noise);
+            auto players = recognizer.recognize(drawn.pixels.data(), drawn.width, drawn.height);
+            auto screenshot = make_screenshot(drawn.pixels.data(), drawn.width, drawn.height, 4);
+
+            if(players.size() < rows.size()) {
+                failures.add("dp_decoding=%i noise=%g: read %zu rows instead of %zu\n", dp_decoding, noise, players.size(), rows.size());
+                continue;
+            }
+
+            for(std::size_t r = 0; r < rows.size(); r++) {
+                const auto &name = players[r].name;
+
+                // The old fixes must leave whatever was read alone
+                auto fixed = fix_errors(compiled, screenshot.monochrome, name, drawn.name_x, drawn.name_y + static_cast<std::uint32_t>(r) * SYNTHETIC_ROW_HEIGHT);
+                if(fixed != name) {
+                    failures.add("dp_decoding=%i noise=%g: read \"%s\", which the old fixes would make \"%s\"\n", dp_decoding, noise, name.c_str(), fixed.c_str());
+                }
+
+                // And that's exactly what was drawn
+                if(name != rows[r].name) {
+                    failures.add("dp_decoding=%i noise=%g: read \"%s\" instead of \"%s\"\n", dp_decoding, noise, name.c_str(), rows[r].name.c_str());
+                }
+            }
+        }
+    }
+
+    return failures.get_exit_status();
+}
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "synthetic.hpp"
+#include "matcher.hpp"
+#include "eprintf.hpp"
+
+int main() {
+    SyntheticRandom random(9);
+    TestFailures failures;
+
+    auto font = make_synthetic_font();
+    auto screenshot = make_synthetic_screenshot(font, { { "Iil leel", true, 3, 2, 3, 4 }, { "amen2Z", false, 15, 6, 7, 8 } }, 6, 0.02);
+    auto image = BitImage::pack(make_monochrome_image(screenshot), 1);
+    Matcher matcher(image);
+
+    std::vector<BitImage> templates;
+    for(const char *text : { "Name", "Assists", "Iil leel", "amen2Z", "2" }) {
+        templates.push_back(draw_template(font, text));
+    }
+    for(int t = 0; t < 6; t++) {
+        templates.push_back(BitImage::pack(make_random_image(random, random.range(1, 130), random.range(1, 20), random.range(0, 100) / 100.0)));
+    }
+
+    // CTest forces correlation in the frequency domain, which has to score every position in the band exactly as
+    // matching it directly does, including positions near the edges where the template doesn't fit
+    for(const auto &text : templates) {
+        for(int b = 0; b < 8; b++) {
+            std::uint32_t min_x = random.range(0, image.width - 1);
+            std::uint32_t min_y = b == 0 ? 120 : random.range(0, image.height - 1);
+            std::uint32_t max_x = b == 0 ? image.width : std::min(image.width + 4, min_x + random.range(1, 200));
+            std::uint32_t max_y = b == 0 ? 170 : std::min(image.height + 4, min_y + random.range(1, 40));
+
+            auto map = matcher.correlate(text, min_x, min_y, max_x, max_y);
+            if(!map.has_value()) {
+                eprintf("\"%s\" wasn't correlated; is CARNAGE_REPORTER_CORRELATION=fft set?\n", text.text.c_str());
+                return EXIT_FAILURE;
+            }
+
+            for(std::uint32_t y = min_y; y < max_y; y++) {
+                for(std::uint32_t x = min_x; x < max_x; x++) {
+                    float expected = matcher.match(text, x, y);
+                    if(map->at(x, y) != expected) {
+                        failures.add("%ux%u \"%s\" at %u,%u correlated to %f instead of %f\n", text.width, text.height, text.text.c_str(), x, y, map->at(x, y), expected);
+                    }
+                }
+            }
+        }
+    }
+
+    return failures.get_exit_status();
+}
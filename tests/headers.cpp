@@ -0,0 +1,130 @@
+#include <array>
+#include <vector>
+
+#include "synthetic.hpp"
+#include "recognizer.hpp"
+
+/**
+ * Replace some of the pixels in a rectangle of a screenshot with random grays
+ * @param screenshot screenshot to add noise to
+ * @param random     random number generator
+ * @param x          left of the rectangle
+ * @param y          top of the rectangle
+ * @param width      width of the rectangle
+ * @param height     height of the rectangle
+ * @param noise      fraction of the pixels to replace
+ */
+static void add_noise(SyntheticScreenshot &screenshot, SyntheticRandom &random, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height, double noise) {
+    for(std::uint32_t py = y; py < y + height && py < screenshot.height; py++) {
+        for(std::uint32_t px = x; px < x + width && px < screenshot.width; px++) {
+            if(random.chance(noise)) {
+                auto gray = static_cast<std::uint8_t>(random.range(0, 255));
+                auto *pixel = screenshot.pixels.data() + (px + static_cast<std::size_t>(py) * screenshot.width) * 4;
+                pixel[0] = pixel[1] = pixel[2] = gray;
+            }
+        }
+    }
+}
+
+int main() {
+    SyntheticRandom random(17);
+    TestFailures failures;
+
+    auto font = make_synthetic_font();
+    Recognizer recognizer(font);
+    const auto &compiled = recognizer.get_font();
+    std::uint32_t line_height = compiled.get_ascending_height();
+
+    const char *header_names[] = { "Name", "Score", "Kills", "Assists", "Deaths" };
+    std::vector<BitImage> headers;
+    for(const char *header : header_names) {
+        headers.push_back(compiled.draw(header));
+    }
+
+    std::size_t found_all = 0;
+    std::size_t missed = 0;
+
+    for(std::uint64_t seed = 1; seed <= 12; seed++) {
+        // Every header band gets a little noise, and every other screenshot has one header drowned out
+        auto screenshot = make_synthetic_screenshot(font, { { "Zeal2", true, 10, 2, 3, 4 }, { "manna", false, 5, 6, 7, 8 } }, seed, 0.02);
+        add_noise(screenshot, random, 100, screenshot.header_y - 10, screenshot.width, 2 * SYNTHETIC_ROW_HEIGHT, 0.03);
+        if(seed % 2 == 0) {
+            std::size_t h = seed / 2 % headers.size();
+            add_noise(screenshot, random, screenshot.column_x[h], screenshot.header_y, headers[h].width, headers[h].height, 0.4 + seed * 0.02);
+        }
+
+        auto image = make_screenshot(screenshot.pixels.data(), screenshot.width, screenshot.height, 4);
+        Matcher matcher(image.monochrome);
+
+        // Each header is the best window in its band at full resolution, and is found only if that reaches the minimum;
+        // otherwise the search stops there
+        std::array<MatchPosition, 5> expected = {};
+        std::size_t expected_missing = headers.size();
+        for(std::size_t h = 0; h < headers.size(); h++) {
+            std::uint32_t min_x = h == 0 ? 120 : expected[h - 1].x;
+            std::uint32_t min_y = h == 0 ? 120 : expected[0].y - 10;
+            expected[h] = { min_x, min_y, 0.0F };
+            for(std::uint32_t y = min_y; y < min_y + line_height; y++) {
+                for(std::uint32_t x = min_x; x < image.monochrome.width; x++) {
+                    float score = matcher.match(headers[h], x, y);
+                    if(score > expected[h].score) {
+                        expected[h] = { x, y, score };
+                    }
+                }
+            }
+            if(expected[h].score < MINIMUM_HEADER_MATCH) {
+                expected_missing = h;
+                break;
+            }
+        }
+
+        try {
+            auto found = recognizer.find_headers(matcher);
+            if(expected_missing < headers.size()) {
+                failures.add("screenshot %llu: \"%s\" was found at %u,%u (%f), but it only matched %f anywhere\n", static_cast<unsigned long long>(seed), header_names[expected_missing], found[expected_missing].x, found[expected_missing].y, found[expected_missing].score, expected[expected_missing].score);
+                continue;
+            }
+            for(std::size_t h = 0; h < headers.size(); h++) {
+                if(found[h].x != expected[h].x || found[h].y != expected[h].y || found[h].score != expected[h].score) {
+                    failures.add("screenshot %llu: \"%s\" was found at %u,%u (%f) instead of %u,%u (%f)\n", static_cast<unsigned long long>(seed), header_names[h], found[h].x, found[h].y, found[h].score, expected[h].x, expected[h].y, expected[h].score);
+                }
+            }
+            found_all++;
+        }
+        catch(CarnageError &e) {
+            const auto &miss = e.get_header_miss();
+            if(e.get_kind() != ErrorKind::HEADER_NOT_FOUND || !miss.has_value()) {
+                failures.add("screenshot %llu: %s\n", static_cast<unsigned long long>(seed), e.what());
+                continue;
+            }
+            if(expected_missing == headers.size()) {
+                failures.add("screenshot %llu: %s, but every header matched at least %f\n", static_cast<unsigned long long>(seed), e.what(), MINIMUM_HEADER_MATCH);
+                continue;
+            }
+
+            // The best guess is the best window anywhere in the band, and reading the screenshot gives up the same way
+            const auto &missing = expected[expected_missing];
+            if(miss->header != header_names[expected_missing] || miss->x != missing.x || miss->y != missing.y || miss->best_score != missing.score) {
+                failures.add("screenshot %llu: the best guess for \"%s\" was %u,%u (%f) instead of \"%s\" at %u,%u (%f)\n", static_cast<unsigned long long>(seed), miss->header.c_str(), miss->x, miss->y, miss->best_score, header_names[expected_missing], missing.x, missing.y, missing.score);
+            }
+            try {
+                recognizer.recognize(screenshot.pixels.data(), screenshot.width, screenshot.height);
+                failures.add("screenshot %llu: reading it didn't fail on \"%s\"\n", static_cast<unsigned long long>(seed), header_names[expected_missing]);
+            }
+            catch(CarnageError &read_error) {
+                const auto &read_miss = read_error.get_header_miss();
+                if(!read_miss.has_value() || read_miss->header != miss->header || read_miss->x != miss->x || read_miss->y != miss->y) {
+                    failures.add("screenshot %llu: reading it failed with %s instead of %s\n", static_cast<unsigned long long>(seed), read_error.what(), e.what());
+                }
+            }
+            missed++;
+        }
+    }
+
+    // Both outcomes have to have been checked
+    if(found_all == 0 || missed == 0) {
+        failures.add("%zu screenshots had every header found and %zu had one missing; both have to happen\n", found_all, missed);
+    }
+
+    return failures.get_exit_status();
+}
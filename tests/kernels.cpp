@@ -0,0 +1,70 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "synthetic.hpp"
+#include "match_kernel.hpp"
+#include "eprintf.hpp"
+
+/** Exit status that tells CTest the test was skipped */
+static constexpr int SKIPPED = 77;
+
+int main(int argc, const char **argv) {
+    // The kernel is picked from CARNAGE_REPORTER_KERNEL, which CTest sets to the kernel named on the command line
+    if(argc != 2) {
+        eprintf("Usage: %s <kernel>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(std::strcmp(get_match_kernel_name(), argv[1]) != 0) {
+        eprintf("This CPU can't run the %s kernel\n", argv[1]);
+        return SKIPPED;
+    }
+
+    MatchKernel kernel = get_match_kernel();
+    SyntheticRandom random(11);
+    TestFailures failures;
+
+    // Every kernel has to count the same misses and stop after the same band as the scalar kernel, for templates of any
+    // height (including ones that don't fill a band or a vector), any number of word columns, any shift, and any limit
+    for(int t = 0; t < 20000; t++) {
+        std::uint32_t text_height = random.range(1, 40);
+        std::uint32_t text_columns = random.range(1, 3);
+        std::uint32_t image_height = text_height + random.range(0, 20);
+        std::uint32_t shift = random.range(0, 63);
+        std::uint32_t last_width = random.range(1, 64);
+        std::uint64_t last_column_mask = last_width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << last_width) - 1;
+
+        // The image has a word column more than the template to shift in from
+        std::vector<std::uint64_t> image(static_cast<std::size_t>(image_height) * (text_columns + 1));
+        std::vector<std::uint64_t> text(static_cast<std::size_t>(text_height) * text_columns);
+        for(auto &word : image) {
+            word = (static_cast<std::uint64_t>(random.next()) << 32) | random.next();
+        }
+        for(auto &word : text) {
+            word = (static_cast<std::uint64_t>(random.next()) << 32) | random.next();
+        }
+
+        // Sometimes the template matches the image exactly, so nothing differs
+        std::uint32_t y = random.range(0, image_height - text_height);
+        if(t % 4 == 0) {
+            for(std::uint32_t column = 0; column < text_columns; column++) {
+                for(std::uint32_t row = 0; row < text_height; row++) {
+                    const auto *low = image.data() + column * image_height + y + row;
+                    text[column * text_height + row] = shift ? (low[0] >> shift) | (low[image_height] << (64 - shift)) : low[0];
+                }
+            }
+        }
+
+        std::uint32_t total = text_height * text_columns * 64;
+        std::uint32_t miss_limit = t % 3 == 0 ? total : random.range(0, total / 2);
+
+        std::uint32_t expected_rows, rows;
+        auto expected = count_misses_scalar(image.data() + y, image_height, text.data(), text_height, text_columns, last_column_mask, shift, miss_limit, expected_rows);
+        auto misses = kernel(image.data() + y, image_height, text.data(), text_height, text_columns, last_column_mask, shift, miss_limit, rows);
+        if(misses != expected || rows != expected_rows) {
+            failures.add("%s: %u rows x %u columns, shift %u, limit %u: %u misses over %u rows instead of %u over %u\n", argv[1], text_height, text_columns, shift, miss_limit, misses, rows, expected, expected_rows);
+        }
+    }
+
+    return failures.get_exit_status();
+}
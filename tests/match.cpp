@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "synthetic.hpp"
+#include "bit_image.hpp"
+#include "screenshot.hpp"
+
+/**
+ * Copy part of an image, so some templates match exactly somewhere
+ * @param image  image to copy from
+ * @param x      left of the part to copy
+ * @param y      top of the part to copy
+ * @param width  width of the part to copy
+ * @param height height of the part to copy
+ * @return       copy
+ */
+static MonochromeImage crop(const MonochromeImage &image, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height) {
+    MonochromeImage cropped { width, height, {}, {} };
+    for(std::uint32_t row = 0; row < height; row++) {
+        const auto *start = image.pixels.data() + x + static_cast<std::size_t>(y + row) * image.width;
+        cropped.pixels.insert(cropped.pixels.end(), start, start + width);
+    }
+    return cropped;
+}
+
+int main() {
+    SyntheticRandom random(7);
+    TestFailures failures;
+
+    // A random image, and the monochrome plane of a screenshot with text on it, which is packed straight from its
+    // pixels rather than from a monochrome image
+    auto font = make_synthetic_font();
+    auto screenshot = make_synthetic_screenshot(font, { { "lilI2Zaenm", true, 1, 2, 3, 4 }, { "mill Inn", false, 50, 6, 7, 8 } }, 3, 0.02);
+    std::vector<MonochromeImage> images = { make_random_image(random, 300, 70, 0.4), make_monochrome_image(screenshot) };
+    std::vector<BitImage> packed = { BitImage::pack(images[0], 1), make_screenshot(screenshot.pixels.data(), screenshot.width, screenshot.height, 4).monochrome };
+
+    // Packed matching has to give exactly the score that comparing bytes did, for templates that span any number of
+    // words at any offset, including positions where they don't fit
+    for(std::size_t i = 0; i < images.size(); i++) {
+        const auto &image = images[i];
+        const auto &image_bits = packed[i];
+
+        for(int t = 0; t < 400; t++) {
+            std::uint32_t width = random.range(1, 140);
+            std::uint32_t height = random.range(1, 16);
+            MonochromeImage text;
+            if(t % 2 == 0 && width <= image.width && height <= image.height) {
+                text = crop(image, random.range(0, image.width - width), random.range(0, image.height - height), width, height);
+            }
+            else {
+                text = make_random_image(random, width, height, random.range(0, 100) / 100.0);
+            }
+            auto text_bits = BitImage::pack(text);
+
+            for(int p = 0; p < 20; p++) {
+                std::uint32_t x = random.range(0, image.width - std::min(width, image.width) + 3);
+                std::uint32_t y = random.range(0, image.height - std::min(height, image.height) + 3);
+                float expected = reference_match(image, text, x, y);
+                float score = match(image_bits, text_bits, x, y);
+                if(score != expected) {
+                    failures.add("image %zu: %ux%u template at %u,%u scored %f instead of %f\n", i, width, height, x, y, score, expected);
+                }
+
+                // Giving up early can't change a score that beats the threshold, or make one that doesn't look like it
+                // does, even at ties and one pixel to either side of them
+                std::uint32_t total = width * height;
+                bool fits = x + width <= image.width && y + height <= image.height;
+                float thresholds[] = { -1.0F, 0.0F, 0.8F, 1.0F, random.range(0, 1000) / 1000.0F, expected, std::nextafter(expected, 0.0F), std::nextafter(expected, 1.0F), expected - 1.0F / total, expected + 1.0F / total };
+                for(float threshold : thresholds) {
+                    std::uint32_t pixels_compared;
+                    float bounded = match_bounded(image_bits, text_bits, x, y, threshold, pixels_compared);
+                    bool wrong = expected > threshold ? bounded != expected || pixels_compared != (fits ? total : 0) : bounded > threshold || pixels_compared > total;
+                    if(wrong) {
+                        failures.add("image %zu: %ux%u template at %u,%u scored %f (comparing %u pixels) against %f instead of %f\n", i, width, height, x, y, bounded, pixels_compared, threshold, expected);
+                    }
+                }
+            }
+        }
+    }
+
+    return failures.get_exit_status();
+}
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "synthetic.hpp"
+#include "matcher.hpp"
+
+int main() {
+    SyntheticRandom random(5);
+    TestFailures failures;
+
+    auto font = make_synthetic_font();
+    auto screenshot = make_synthetic_screenshot(font, { { "Zeal2", true, 10, 2, 3, 4 }, { "manna", false, 5, 6, 7, 8 } }, 4, 0.02);
+    auto image = BitImage::pack(make_monochrome_image(screenshot), 1);
+    Matcher matcher(image);
+
+    // The summed-area table counts exactly the pixels in a rectangle
+    for(int r = 0; r < 2000; r++) {
+        std::uint32_t x = random.range(0, image.width - 1);
+        std::uint32_t y = random.range(0, image.height - 1);
+        std::uint32_t width = random.range(0, image.width - x);
+        std::uint32_t height = random.range(0, image.height - y);
+        std::uint32_t ink = 0;
+        for(std::uint32_t dy = 0; dy < height; dy++) {
+            for(std::uint32_t dx = 0; dx < width; dx++) {
+                ink += image.get(x + dx, y + dy);
+            }
+        }
+        if(matcher.ink(x, y, width, height) != ink) {
+            failures.add("%ux%u at %u,%u: the table counted %u set pixels instead of %u\n", width, height, x, y, matcher.ink(x, y, width, height), ink);
+        }
+    }
+
+    // Whether or not a template is there, the windows the bound rules out can't hold a better score than it allows
+    std::vector<PyramidTemplate> templates;
+    for(const char *text : { "Name", "Score", "Kills", "Assists", "Deaths", "Zeal2", "manna", "lilI" }) {
+        templates.emplace_back(draw_template(font, text));
+    }
+    for(int t = 0; t < 4; t++) {
+        templates.emplace_back(BitImage::pack(make_random_image(random, random.range(10, 70), random.range(8, 15), 0.3)));
+    }
+
+    for(const auto &text : templates) {
+        const auto &text_drawn = text.text;
+        for(int b = 0; b < 4; b++) {
+            // The band headers are searched for, then random bands
+            std::uint32_t min_x = b == 0 ? 100 : random.range(0, image.width - 1);
+            std::uint32_t min_y = b == 0 ? 120 : random.range(0, image.height - 1);
+            std::uint32_t max_x = b == 0 ? image.width : std::min(image.width, min_x + random.range(1, 300));
+            std::uint32_t max_y = b == 0 ? 170 : std::min(image.height, min_y + random.range(1, 40));
+
+            MatchPosition exhaustive = { min_x, min_y, 0.0F };
+            for(std::uint32_t y = min_y; y < max_y; y++) {
+                for(std::uint32_t x = min_x; x < max_x; x++) {
+                    float score = matcher.match(text_drawn, x, y);
+                    float bound = matcher.upper_bound(text_drawn, x, y);
+                    if(bound < score) {
+                        failures.add("\"%s\" at %u,%u scored %f, more than its bound of %f\n", text_drawn.text.c_str(), x, y, score, bound);
+                    }
+                    if(score > exhaustive.score) {
+                        exhaustive = { x, y, score };
+                    }
+                }
+            }
+
+            // Header searches skip windows by the coarse search's score, the minimum, and the best so far, and have to
+            // end up at the same place matching every window does, whether or not it reaches the minimum
+            for(float minimum : { 0.85F, 0.0F, 1.0F, exhaustive.score, std::nextafter(exhaustive.score, 1.0F) }) {
+                auto found = matcher.find_best(text, min_x, min_y, max_x, max_y, minimum);
+                if(found.x != exhaustive.x || found.y != exhaustive.y || found.score != exhaustive.score) {
+                    failures.add("\"%s\" in %u,%u-%u,%u was found at %u,%u (%f) with a minimum of %f, but matching every window found %u,%u (%f)\n", text_drawn.text.c_str(), min_x, min_y, max_x, max_y, found.x, found.y, found.score, minimum, exhaustive.x, exhaustive.y, exhaustive.score);
+                }
+            }
+        }
+    }
+
+    return failures.get_exit_status();
+}
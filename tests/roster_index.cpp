@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "synthetic.hpp"
+#include "roster.hpp"
+#include "roster_index.hpp"
+
+int main() {
+    SyntheticRandom random(13);
+    TestFailures failures;
+
+    auto font = make_synthetic_font();
+    auto compiled = CompiledFont::compile(font);
+
+    // A roster with names of the same size, names that differ by a glyph, and names that are prefixes of each other, a
+    // few of which are on the screenshot
+    std::vector<std::string> names = { "Zeal2", "Zeal", "Zea12", "manna", "mamma", "nanna", "lilI2Zaenm", "mill Inn", "Iil leel", "amen2Z" };
+    for(int n = 0; n < 150; n++) {
+        std::string name;
+        for(std::uint32_t length = random.range(1, 14); name.size() < length;) {
+            name += static_cast<char>(random.range(33, 126));
+        }
+        names.push_back(name);
+    }
+    auto roster = Roster::render(compiled, names);
+    const auto &rendered = roster.get_names();
+    RosterIndex index(rendered);
+
+    std::vector<SyntheticRow> rows;
+    for(std::size_t r = 0; r < 8; r++) {
+        rows.push_back(SyntheticRow { names[r * 3 % names.size()], r % 2 == 0, 1, 2, 3, 4 });
+    }
+    auto screenshot = make_synthetic_screenshot(font, rows, 8, 0.03);
+    auto image = BitImage::pack(make_monochrome_image(screenshot), 1);
+    Matcher matcher(image);
+
+    // Every name that beats the minimum when matched has to be a candidate, with a bound no less than its score, and the
+    // candidates have to be in roster order so the best of them is the same name matching every name would pick
+    std::pmr::vector<RosterCandidate> candidates;
+    for(int p = 0; p < 600; p++) {
+        std::uint32_t row = random.range(0, static_cast<std::uint32_t>(rows.size()));
+        std::uint32_t x = p % 3 == 0 ? random.range(0, 639) : screenshot.name_x + random.range(0, 4) - 2;
+        std::uint32_t y = p % 3 == 0 ? random.range(0, 479) : screenshot.name_y + row * SYNTHETIC_ROW_HEIGHT + random.range(0, 4) - 2;
+        float minimum = p % 2 == 0 ? 0.80F : random.range(0, 100) / 100.0F;
+
+        index.find_candidates(matcher, x, y, minimum, candidates);
+
+        if(!std::is_sorted(candidates.begin(), candidates.end(), [](const RosterCandidate &a, const RosterCandidate &b) { return a.name < b.name; })) {
+            failures.add("Candidates at %u,%u aren't in roster order\n", x, y);
+        }
+
+        for(std::size_t n = 0; n < rendered.size(); n++) {
+            float score = matcher.match(rendered[n], x, y);
+            auto found = std::find_if(candidates.begin(), candidates.end(), [n](const RosterCandidate &candidate) {
+                return candidate.name == n;
+            });
+
+            bool wrong = found == candidates.end() ? score > minimum : found->bound < score || !(found->bound > minimum);
+            if(wrong) {
+                failures.add("\"%s\" at %u,%u scored %f against a minimum of %f, but its bound was %f\n", names[n].c_str(), x, y, score, minimum, found == candidates.end() ? -1.0F : found->bound);
+            }
+        }
+    }
+
+    return failures.get_exit_status();
+}
@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+
+#include "synthetic.hpp"
+
+namespace {
+    struct SyntheticGlyph {
+        std::int16_t advance;
+        std::int16_t width;
+        std::int16_t height;
+        std::int16_t origin_y;
+        std::vector<std::uint8_t> pixels;
+    };
+
+    constexpr std::int16_t ASCENDING_HEIGHT = 12;
+    constexpr std::int16_t DESCENDING_HEIGHT = 3;
+
+    SyntheticGlyph random_glyph(SyntheticRandom &random, bool number) {
+        SyntheticGlyph glyph;
+        glyph.width = static_cast<std::int16_t>(random.range(4, 8));
+        glyph.height = number ? ASCENDING_HEIGHT - 1 : static_cast<std::int16_t>(random.range(7, 12));
+        glyph.advance = glyph.width + 1;
+        glyph.origin_y = number ? glyph.height : static_cast<std::int16_t>(random.range(glyph.height - 2, std::min<std::int16_t>(glyph.height, ASCENDING_HEIGHT)));
+        for(std::int16_t i = 0; i < glyph.width * glyph.height; i++) {
+            glyph.pixels.push_back(random.chance(0.45) ? 0xFF : 0x00);
+        }
+        return glyph;
+    }
+
+    // Flip a few pixels of a glyph, but always at least two
+    SyntheticGlyph similar_glyph(const SyntheticGlyph &glyph, SyntheticRandom &random) {
+        auto similar = glyph;
+        std::size_t flips = std::max<std::size_t>(2, similar.pixels.size() / 12);
+        for(std::size_t i = 0; i < flips; i++) {
+            auto &pixel = similar.pixels[random.range(0, static_cast<std::uint32_t>(similar.pixels.size() - 1))];
+            pixel = pixel ? 0x00 : 0xFF;
+        }
+        return similar;
+    }
+
+    // Add columns to the right of a glyph
+    SyntheticGlyph wider_glyph(const SyntheticGlyph &glyph, std::int16_t columns, SyntheticRandom &random) {
+        SyntheticGlyph wider = glyph;
+        wider.width += columns;
+        wider.advance += columns;
+        wider.pixels.clear();
+        for(std::int16_t y = 0; y < glyph.height; y++) {
+            for(std::int16_t x = 0; x < wider.width; x++) {
+                wider.pixels.push_back(x < glyph.width ? glyph.pixels[x + y * glyph.width] : (random.chance(0.6) ? 0xFF : 0x00));
+            }
+        }
+        return similar_glyph(wider, random);
+    }
+}
+
+void TestFailures::add(const char *format, ...) {
+    if(this->count++ < MAX_PRINTED) {
+        std::va_list arguments;
+        va_start(arguments, format);
+        std::vfprintf(stderr, format, arguments);
+        va_end(arguments);
+    }
+}
+
+int TestFailures::get_exit_status() const {
+    return this->count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+FontTag make_synthetic_font(std::uint64_t seed) {
+    SyntheticRandom random(seed);
+
+    std::vector<SyntheticGlyph> glyphs(256);
+    // Rows are found by the blank lines between them in the deaths column, so numbers fill all but the top line above
+    // the baseline
+    for(int c = 33; c < 127; c++) {
+        glyphs[c] = random_glyph(random, c == '-' || (c >= '0' && c <= '9'));
+    }
+    glyphs[' '].advance = 4;
+    glyphs['i'] = similar_glyph(glyphs['l'], random);
+    glyphs['I'] = similar_glyph(glyphs['l'], random);
+    glyphs['Z'] = similar_glyph(glyphs['2'], random);
+    glyphs['e'] = similar_glyph(glyphs['a'], random);
+    glyphs['m'] = wider_glyph(glyphs['n'], 2, random);
+
+    FontTag tag = {};
+    tag.font.ascending_height = swap_endian(ASCENDING_HEIGHT);
+    tag.font.descending_height = swap_endian(DESCENDING_HEIGHT);
+    tag.characters.resize(256);
+    tag.source_hash = seed;
+
+    for(int c = 32; c < 127; c++) {
+        const auto &glyph = glyphs[c];
+        auto &character = tag.characters[c];
+        character = {};
+        character.character = swap_endian(static_cast<std::int16_t>(c));
+        character.character_width = swap_endian(glyph.advance);
+        character.bitmap_width = swap_endian(glyph.width);
+        character.bitmap_height = swap_endian(glyph.height);
+        character.bitmap_origin_y = swap_endian(glyph.origin_y);
+        character.pixels_offset = swap_endian(static_cast<std::uint32_t>(tag.pixels.size()));
+        for(auto pixel : glyph.pixels) {
+            Monochrome monochrome;
+            monochrome = pixel;
+            tag.pixels.push_back(monochrome);
+        }
+    }
+    tag.font.characters.count = swap_endian(static_cast<std::uint32_t>(95));
+    tag.font.pixels.count = swap_endian(static_cast<std::uint32_t>(tag.pixels.size()));
+
+    return tag;
+}
+
+SyntheticScreenshot make_synthetic_screenshot(const FontTag &font, const std::vector<SyntheticRow> &rows, std::uint64_t seed, double noise) {
+    SyntheticRandom random(seed);
+    SyntheticScreenshot screenshot;
+    std::uint32_t width = screenshot.width;
+    std::uint32_t height = screenshot.height;
+
+    auto &pixels = screenshot.pixels;
+    pixels.resize(static_cast<std::size_t>(width) * height * 4);
+    auto set_pixel = [&pixels, width, height](std::uint32_t x, std::uint32_t y, std::uint8_t red, std::uint8_t green, std::uint8_t blue) {
+        if(x < width && y < height) {
+            auto *pixel = pixels.data() + (x + y * width) * 4;
+            pixel[0] = red;
+            pixel[1] = green;
+            pixel[2] = blue;
+            pixel[3] = 0xFF;
+        }
+    };
+    for(std::uint32_t y = 0; y < height; y++) {
+        for(std::uint32_t x = 0; x < width; x++) {
+            auto gray = static_cast<std::uint8_t>(random.range(0, 40));
+            set_pixel(x, y, gray, gray, gray);
+        }
+    }
+
+    auto draw = [&font, &set_pixel](const std::string &text, std::uint32_t x, std::uint32_t y, std::uint8_t red, std::uint8_t green, std::uint8_t blue) {
+        auto drawn = draw_text(text.c_str(), font);
+        filter_monochrome(drawn.pixels);
+        for(std::uint32_t dy = 0; dy < drawn.height; dy++) {
+            for(std::uint32_t dx = 0; dx < drawn.width; dx++) {
+                if(drawn.pixels[dx + dy * drawn.width].intensity) {
+                    set_pixel(x + dx, y + dy, red, green, blue);
+                }
+            }
+        }
+    };
+
+    // Same columns as the screenshots the reader was written against
+    static constexpr std::uint32_t COLUMNS[] = { 140, 330, 400, 460, 540 };
+    static constexpr std::uint32_t HEADER_Y = 130;
+    const char *headers[] = { "Name", "Score", "Kills", "Assists", "Deaths" };
+    for(std::size_t i = 0; i < 5; i++) {
+        draw(headers[i], COLUMNS[i], HEADER_Y, 230, 230, 230);
+    }
+
+    std::uint32_t y = HEADER_Y + SYNTHETIC_ROW_HEIGHT;
+    for(auto &row : rows) {
+        std::uint8_t red = row.red ? 255 : 100;
+        std::uint8_t green = row.red ? 60 : 140;
+        std::uint8_t blue = row.red ? 60 : 255;
+        draw(row.name, COLUMNS[0], y, red, green, blue);
+        draw(std::to_string(row.score), COLUMNS[1], y, red, green, blue);
+        draw(std::to_string(row.kills), COLUMNS[2], y, red, green, blue);
+        draw(std::to_string(row.assists), COLUMNS[3], y, red, green, blue);
+        draw(std::to_string(row.deaths), COLUMNS[4], y, red, green, blue);
+        y += SYNTHETIC_ROW_HEIGHT;
+    }
+
+    // Noise anywhere else would only get in the way of finding the rows and where each name ends
+    y = HEADER_Y + SYNTHETIC_ROW_HEIGHT;
+    for(auto &row : rows) {
+        std::uint32_t name_width = draw_text(row.name.c_str(), font).width;
+        for(std::uint32_t i = 0; name_width > 0 && i < noise * name_width * SYNTHETIC_ROW_HEIGHT; i++) {
+            auto gray = static_cast<std::uint8_t>(random.range(0, 255));
+            set_pixel(COLUMNS[0] + random.range(0, name_width - 1), y + random.range(0, SYNTHETIC_ROW_HEIGHT - 1), gray, gray, gray);
+        }
+        y += SYNTHETIC_ROW_HEIGHT;
+    }
+
+    std::copy(std::begin(COLUMNS), std::end(COLUMNS), screenshot.column_x.begin());
+    screenshot.header_y = HEADER_Y;
+    screenshot.name_x = COLUMNS[0];
+    screenshot.name_y = HEADER_Y + SYNTHETIC_ROW_HEIGHT;
+    return screenshot;
+}
+
+MonochromeImage make_random_image(SyntheticRandom &random, std::uint32_t width, std::uint32_t height, double density) {
+    MonochromeImage image { width, height, std::vector<Monochrome>(static_cast<std::size_t>(width) * height), {} };
+    for(auto &pixel : image.pixels) {
+        pixel = random.chance(density) ? 0xFF : 0x00;
+    }
+    return image;
+}
+
+MonochromeImage make_monochrome_image(const SyntheticScreenshot &screenshot) {
+    MonochromeImage image { screenshot.width, screenshot.height, std::vector<Monochrome>(static_cast<std::size_t>(screenshot.width) * screenshot.height), {} };
+    for(std::size_t i = 0; i < image.pixels.size(); i++) {
+        const auto *pixel = screenshot.pixels.data() + i * 4;
+        image.pixels[i] = Monochrome(ImagePixel { pixel[0], pixel[1], pixel[2], pixel[3] });
+    }
+    filter_monochrome(image.pixels);
+    return image;
+}
+
+BitImage draw_template(const FontTag &font, const char *text) {
+    auto drawn = draw_text(text, font);
+    filter_monochrome(drawn.pixels);
+    return BitImage::pack(drawn);
+}
+
+float reference_match(const MonochromeImage &image, const MonochromeImage &text, std::uint32_t x, std::uint32_t y) {
+    if(x + text.width > image.width || y + text.height > image.height || text.width == 0 || text.height == 0) {
+        return 0.0F;
+    }
+
+    std::uint32_t hits = 0;
+    std::uint32_t total = text.height * text.width;
+
+    for(std::uint32_t ty = 0; ty < text.height; ty++) {
+        for(std::uint32_t tx = 0; tx < text.width; tx++) {
+            const auto &text_pixel = text.pixels[tx + ty * text.width];
+            const auto &image_pixel = image.pixels[tx + x + (ty + y) * image.width];
+
+            std::int32_t difference = static_cast<std::int32_t>(text_pixel.intensity) - image_pixel.intensity;
+            if(difference < 0) {
+                difference *= -1;
+            }
+
+            hits += (difference < 0x10);
+        }
+    }
+
+    return static_cast<float>(hits) / total;
+}
@@ -0,0 +1,171 @@
+#ifndef CARNAGE_REPORTER__TESTS__SYNTHETIC_HPP
+#define CARNAGE_REPORTER__TESTS__SYNTHETIC_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "font.hpp"
+#include "bit_image.hpp"
+
+/**
+ * Small deterministic random number generator, so tests draw the same fonts and screenshots on every platform
+ */
+class SyntheticRandom {
+public:
+    /**
+     * Get the next number
+     * @return random 32-bit number
+     */
+    std::uint32_t next() {
+        this->state ^= this->state << 13;
+        this->state ^= this->state >> 7;
+        this->state ^= this->state << 17;
+        return static_cast<std::uint32_t>(this->state >> 32);
+    }
+
+    /**
+     * Get a number in a range
+     * @param minimum smallest number
+     * @param maximum largest number
+     * @return        random number
+     */
+    std::uint32_t range(std::uint32_t minimum, std::uint32_t maximum) {
+        return minimum + this->next() % (maximum - minimum + 1);
+    }
+
+    /**
+     * Get whether something with a given chance happened
+     * @param chance chance from 0 to 1
+     * @return       true if it happened
+     */
+    bool chance(double chance) {
+        return this->next() < chance * 4294967296.0;
+    }
+
+    SyntheticRandom(std::uint64_t seed) : state(seed * 0x9E3779B97F4A7C15 + 1) {}
+
+private:
+    std::uint64_t state;
+};
+
+/**
+ * Failures found by a test. Only the first few are printed, so one broken case doesn't bury the rest of the output.
+ */
+class TestFailures {
+public:
+    /**
+     * Record a failure
+     * @param format printf format of the message, ending with a newline
+     */
+    void add(const char *format, ...);
+
+    /**
+     * Get what the test should exit with
+     * @return EXIT_SUCCESS if nothing failed, or EXIT_FAILURE
+     */
+    int get_exit_status() const;
+
+private:
+    static constexpr std::size_t MAX_PRINTED = 10;
+    std::size_t count = 0;
+};
+
+/**
+ * A row of a synthetic postgame carnage report
+ */
+struct SyntheticRow {
+    std::string name;
+    bool red;
+    int score;
+    int kills;
+    int assists;
+    int deaths;
+};
+
+/**
+ * A synthetic postgame carnage report
+ */
+struct SyntheticScreenshot {
+    std::uint32_t width = 640;
+    std::uint32_t height = 480;
+
+    /** Pixels, row by row, with four bytes (red, green, blue, and alpha) per pixel */
+    std::vector<std::uint8_t> pixels;
+
+    /** Left of each column, from Name to Deaths */
+    std::array<std::uint32_t, 5> column_x = {};
+
+    /** Top of the headers */
+    std::uint32_t header_y = 0;
+
+    /** Left of the names */
+    std::uint32_t name_x = 0;
+
+    /** Top of the first name */
+    std::uint32_t name_y = 0;
+};
+
+/**
+ * Make a font tag with a random glyph for every printable ASCII character. The glyphs of each of the confusion table's
+ * seed pairs differ on only a few pixels, and 'm' is 'n' with two more columns. Numbers fill all but the top line above
+ * the baseline.
+ * @param seed seed for the glyphs
+ * @return     font tag
+ */
+FontTag make_synthetic_font(std::uint64_t seed = 1);
+
+/**
+ * Draw a postgame carnage report over a noisy background
+ * @param font  font to draw with
+ * @param rows  rows of the report
+ * @param seed  seed for the background
+ * @param noise fraction of the pixels under each name to replace with random grays after drawing
+ * @return      screenshot
+ */
+SyntheticScreenshot make_synthetic_screenshot(const FontTag &font, const std::vector<SyntheticRow> &rows, std::uint64_t seed, double noise);
+
+/**
+ * Make an image with random pixels set, already thresholded
+ * @param random  random number generator
+ * @param width   width in pixels
+ * @param height  height in pixels
+ * @param density chance of each pixel being set
+ * @return        image where every pixel is either 0x00 or 0xFF
+ */
+MonochromeImage make_random_image(SyntheticRandom &random, std::uint32_t width, std::uint32_t height, double density);
+
+/**
+ * Threshold the pixels of a synthetic screenshot the same way screenshots are thresholded when they're read
+ * @param screenshot screenshot
+ * @return           image where every pixel is either 0x00 or 0xFF
+ */
+MonochromeImage make_monochrome_image(const SyntheticScreenshot &screenshot);
+
+/**
+ * Render text as a thresholded, packed template
+ * @param font font to render with
+ * @param text text to render
+ * @return     template
+ */
+BitImage draw_template(const FontTag &font, const char *text);
+
+/**
+ * Score a template one pixel at a time, the way it was done before images were packed into bits. Packed matching has to
+ * give exactly this score.
+ * @param image image being searched
+ * @param text  template
+ * @param x     left of the template in the image
+ * @param y     top of the template in the image
+ * @return      fraction of pixels that match, or 0 if the template does not fit
+ */
+float reference_match(const MonochromeImage &image, const MonochromeImage &text, std::uint32_t x, std::uint32_t y);
+
+/**
+ * Height of each row of a synthetic screenshot
+ */
+static constexpr std::uint32_t SYNTHETIC_ROW_HEIGHT = 14;
+
+#endif